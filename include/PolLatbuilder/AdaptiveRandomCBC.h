@@ -0,0 +1,268 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__ADAPTIVE_RANDOM_CBC_H
+#define POLLATBUILDER__ADAPTIVE_RANDOM_CBC_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/ModularPoly.h"
+#include "PolLatbuilder/GenSeq/CoprimePolynomials.h"
+#include "PolLatbuilder/GenSeq/Modular.h"
+#include "PolLatbuilder/MeritSeq/CoordUniformCBC.h"
+#include "PolLatbuilder/Parallel/SharedBound.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace PolLatBuilder {
+
+/**
+ * Stopping rule of AdaptiveRandomCBC.
+ */
+struct AdaptiveStopping {
+   /// Maximum number of candidates per coordinate; 0 for the number of
+   /// polynomials coprime with the modulus.
+   uint64_t maxSamples = 0;
+   /// Minimum number of candidates per coordinate before testing the rule.
+   uint64_t minSamples = 256;
+   /// Number of smallest merits used to model the lower tail.
+   size_t tailSize = 32;
+   /// Relative decrease of the best merit that counts as an improvement.
+   Real relativeImprovement = 0.01;
+   /// The search of a coordinate stops when the probability of an
+   /// improvement with the remaining samples falls below this value.
+   double threshold = 0.05;
+};
+
+/**
+ * Number of evaluations of one coordinate of an AdaptiveRandomCBC search.
+ */
+struct AdaptiveCoordinateReport {
+   /// Number of candidates evaluated.
+   uint64_t evaluated = 0;
+   /// Maximum number of candidates.
+   uint64_t budget = 0;
+   /// Estimated probability of an improvement with the remaining budget
+   /// when the search stopped, or 1 if it used the whole budget.
+   double improvementProbability = 1.0;
+
+   uint64_t saved() const
+   { return budget - evaluated; }
+};
+
+/**
+ * Number of evaluations of an AdaptiveRandomCBC search.
+ */
+struct AdaptiveRandomReport {
+   std::vector<AdaptiveCoordinateReport> coordinates;
+
+   uint64_t evaluated() const
+   {
+      uint64_t n = 0;
+      for (const auto& c : coordinates)
+         n += c.evaluated;
+      return n;
+   }
+
+   uint64_t budget() const
+   {
+      uint64_t n = 0;
+      for (const auto& c : coordinates)
+         n += c.budget;
+      return n;
+   }
+
+   /// Returns the number of evaluations saved with respect to a random
+   /// search with a fixed number of samples equal to the budget.
+   uint64_t saved() const
+   { return budget() - evaluated(); }
+
+   double savedFraction() const
+   { return budget() ? double(saved()) / double(budget()) : 0.0; }
+};
+
+/**
+ * Random component-by-component construction that adapts the number of
+ * candidates of each coordinate.
+ *
+ * The candidates of a coordinate are drawn uniformly, with replacement,
+ * among the polynomials coprime with the modulus, as with
+ * Traversal::Random, and evaluated in groups of
+ * CoordUniformCBC::bitSliceWidth().  After each group, the lower tail of
+ * the distribution of the merits is modeled from the tailSize smallest
+ * merits \f$x_{(1)} \leq \dots \leq x_{(k)}\f$ out of \f$n\f$: below
+ * \f$u = x_{(k)}\f$, the distribution function is taken as \f$F(x) =
+ * (k/n) \exp((x - u)/\sigma)\f$, with the maximum likelihood estimate
+ * \f$\sigma = \sum_i (u - x_{(i)})/(k-1)\f$.  The probability that one of
+ * the \f$R\f$ remaining samples improves on the best merit by the relative
+ * amount relativeImprovement is then \f$1 - (1 - F(x_{(1)}(1 - \delta)))^R\f$,
+ * and the coordinate is selected when it falls below the threshold.
+ *
+ * Only the tail is needed, so the candidates are evaluated with early
+ * abandoning against \f$u\f$.
+ *
+ * \tparam KERNEL    Kernel of the figure of merit.
+ * \tparam ACC       Accumulator of the figure of merit.
+ */
+template <class KERNEL, class ACC = Functor::Sum>
+class AdaptiveRandomCBC {
+public:
+   typedef MeritSeq::CoordUniformCBC<KERNEL, ACC> Evaluator;
+
+   /**
+    * Constructor.
+    *
+    * \param evaluator  Evaluator for the size parameter of the lattices; the
+    *                   construction extends its base lattice.
+    * \param stopping   Stopping rule.
+    * \param seed       Seed of the random generator.
+    */
+   AdaptiveRandomCBC(Evaluator evaluator, AdaptiveStopping stopping = AdaptiveStopping(), uint64_t seed = 0):
+      m_eval(std::move(evaluator)),
+      m_stopping(stopping),
+      m_genSeq(PolyModulus::create(m_eval.baseLat().sizeParam().polynomial()),
+            GenSeq::CoprimePolynomials<>(m_eval.baseLat().sizeParam().polynomial())),
+      m_rand(seed)
+   {
+      if (m_stopping.tailSize < 2)
+         throw std::runtime_error("AdaptiveRandomCBC: the tail size must be at least 2");
+      if (m_stopping.maxSamples == 0)
+         m_stopping.maxSamples = m_genSeq.size();
+   }
+
+   /**
+    * Returns the evaluator, whose base lattice is the lattice constructed so
+    * far.
+    */
+   const Evaluator& evaluator() const
+   { return m_eval; }
+
+   const AdaptiveStopping& stopping() const
+   { return m_stopping; }
+
+   /**
+    * Returns the number of evaluations of the coordinates selected so far.
+    */
+   const AdaptiveRandomReport& report() const
+   { return m_report; }
+
+   /**
+    * Selects the next coordinate and returns the merit of the extended
+    * lattice.
+    */
+   Real selectNext()
+   {
+      const uint64_t budget = m_stopping.maxSamples;
+      const size_t k = m_stopping.tailSize;
+      std::uniform_int_distribution<size_t> unif(0, m_genSeq.size() - 1);
+
+      AdaptiveCoordinateReport rep;
+      rep.budget = budget;
+      // max-heap of the k smallest merits
+      std::vector<Real> tail;
+      tail.reserve(k + 1);
+      Parallel::SharedBound bound;
+      ModularPoly best;
+      Real bestMerit = std::numeric_limits<Real>::infinity();
+
+      std::vector<ModularPoly> group;
+      Real merits[Evaluator::bitSliceWidth()];
+      while (rep.evaluated < budget) {
+         group.clear();
+         while (group.size() < Evaluator::bitSliceWidth() and rep.evaluated + group.size() < budget)
+            group.push_back(m_genSeq[unif(m_rand)]);
+         m_eval.merits(group.begin(), group.end(), merits, &bound);
+         rep.evaluated += group.size();
+
+         for (size_t c = 0; c < group.size(); c++) {
+            if (merits[c] < bestMerit) {
+               bestMerit = merits[c];
+               best = group[c];
+            }
+            if (tail.size() < k or merits[c] < tail.front()) {
+               tail.push_back(merits[c]);
+               std::push_heap(tail.begin(), tail.end());
+               if (tail.size() > k) {
+                  std::pop_heap(tail.begin(), tail.end());
+                  tail.pop_back();
+               }
+            }
+         }
+         if (tail.size() == k)
+            bound.improve(tail.front());
+
+         if (rep.evaluated >= m_stopping.minSamples and tail.size() == k and rep.evaluated < budget) {
+            rep.improvementProbability = improvementProbability(tail, bestMerit, rep.evaluated, budget - rep.evaluated);
+            if (rep.improvementProbability < m_stopping.threshold)
+               break;
+         }
+      }
+      if (rep.evaluated == budget)
+         rep.improvementProbability = 1.0;
+
+      m_eval.select(best);
+      m_report.coordinates.push_back(rep);
+      return m_eval.baseMerit();
+   }
+
+   /**
+    * Selects coordinates until the base lattice has dimension \c dimension
+    * and returns its merit.
+    */
+   Real run(Dimension dimension)
+   {
+      while (m_eval.baseLat().dimension() < dimension)
+         selectNext();
+      return m_eval.baseMerit();
+   }
+
+private:
+   Evaluator m_eval;
+   AdaptiveStopping m_stopping;
+   GenSeq::Modular<GenSeq::CoprimePolynomials<>> m_genSeq;
+   std::mt19937_64 m_rand;
+   AdaptiveRandomReport m_report;
+
+   /**
+    * Returns the probability that one of \c remaining samples improves on
+    * \c best, for the exponential model of the lower tail fitted to the
+    * smallest merits \c tail out of \c n samples.
+    */
+   double improvementProbability(const std::vector<Real>& tail, Real best, uint64_t n, uint64_t remaining) const
+   {
+      const Real u = *std::max_element(tail.begin(), tail.end());
+      Real sum = 0.0;
+      for (const auto x : tail)
+         sum += u - x;
+      const Real sigma = sum / Real(tail.size() - 1);
+      if (not (sigma > 0.0))
+         return 0.0;
+      const Real target = best - m_stopping.relativeImprovement * std::abs(best);
+      const double p = std::min(1.0, double(tail.size()) / double(n) * std::exp((target - u) / sigma));
+      if (p >= 1.0)
+         return 1.0;
+      return -std::expm1(double(remaining) * std::log1p(-p));
+   }
+};
+
+}
+
+#endif
@@ -0,0 +1,348 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__ANYTIME_SEARCH_H
+#define POLLATBUILDER__ANYTIME_SEARCH_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/LatDef.h"
+#include "PolLatbuilder/ModularPoly.h"
+#include "PolLatbuilder/GenSeq/CoprimePolynomials.h"
+#include "PolLatbuilder/GenSeq/Modular.h"
+#include "PolLatbuilder/MeritSeq/CoordUniformCBC.h"
+#include "PolLatbuilder/Parallel/SharedBound.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace PolLatBuilder {
+
+/**
+ * Point in time after which a search must return.
+ */
+class Deadline {
+public:
+   typedef std::chrono::steady_clock Clock;
+
+   /**
+    * Constructor for a deadline \c seconds from now.
+    */
+   explicit Deadline(double seconds = std::numeric_limits<double>::infinity()):
+      m_start(Clock::now()),
+      m_end(seconds < 1e9 ? m_start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds)) : Clock::time_point::max())
+   {}
+
+   /**
+    * Returns \c true if the deadline has passed; costs a read of the
+    * monotonic clock.
+    */
+   bool expired() const
+   { return Clock::now() >= m_end; }
+
+   /**
+    * Returns the number of seconds since the construction.
+    */
+   double elapsedSeconds() const
+   { return std::chrono::duration<double>(Clock::now() - m_start).count(); }
+
+   /**
+    * Returns the number of seconds left, or zero if the deadline has passed.
+    */
+   double remainingSeconds() const
+   {
+      if (m_end == Clock::time_point::max())
+         return std::numeric_limits<double>::infinity();
+      const auto now = Clock::now();
+      return now >= m_end ? 0.0 : std::chrono::duration<double>(m_end - now).count();
+   }
+
+private:
+   Clock::time_point m_start;
+   Clock::time_point m_end;
+};
+
+/**
+ * State of an AnytimeSearch.
+ */
+struct AnytimeSnapshot {
+   /// Best lattice found so far; for CBC, the components selected so far.
+   LatDef<LatType::ORDINARY> lat;
+   /// Merit of \c lat, or infinity if no lattice was evaluated yet.
+   Real merit = std::numeric_limits<Real>::infinity();
+   /// Number of candidates evaluated.
+   uint64_t evaluated = 0;
+   /// Number of candidates in the search space.
+   double spaceSize = 0.0;
+   /// Seconds since the start of the search.
+   double elapsedSeconds = 0.0;
+   /// \c true if the search visited the whole space before the deadline.
+   bool complete = false;
+
+   /// Returns the fraction of the search space that was evaluated.
+   double coverage() const
+   { return spaceSize > 0.0 ? double(evaluated) / spaceSize : 0.0; }
+};
+
+/**
+ * Searches that return the best lattice found before a deadline.
+ *
+ * The candidate generators, the polynomials coprime with the modulus, are
+ * visited in an order that spreads over the whole sequence from the start
+ * (see order()), rather than from the smallest ones, so that a good
+ * candidate is usually met early.  The deadline is checked once per group
+ * of CoordUniformCBC::bitSliceWidth() candidates for CBC, and once per
+ * lattice for the other searches.
+ *
+ * snapshot() can be called by other threads while a search is running, to
+ * read the best lattice found so far and the fraction of the search space
+ * covered.  A search object runs one search at a time.
+ *
+ * Example:
+ * \code
+ * AnytimeSearch<Kernel::PAlphaPLR> search(
+ *       MeritSeq::coordUniformCBC(sizeParam, kernel, weights), dimension);
+ * const auto result = search.korobov(Deadline(2.0));
+ * \endcode
+ *
+ * \tparam KERNEL    Kernel of the figure of merit.
+ * \tparam ACC       Accumulator of the figure of merit.
+ */
+template <class KERNEL, class ACC = Functor::Sum>
+class AnytimeSearch {
+public:
+   typedef MeritSeq::CoordUniformCBC<KERNEL, ACC> Evaluator;
+
+   /**
+    * Constructor.
+    *
+    * \param evaluator  Evaluator for the size parameter of the lattices.
+    * \param dimension  Dimension of the lattices.
+    */
+   AnytimeSearch(Evaluator evaluator, Dimension dimension):
+      m_eval(std::move(evaluator)),
+      m_dimension(dimension),
+      m_modulus(PolyModulus::create(m_eval.baseLat().sizeParam().polynomial())),
+      m_genSeq(m_modulus, GenSeq::CoprimePolynomials<>(m_modulus->polynomial())),
+      m_stride(stride(m_genSeq.size())),
+      m_evaluated(0)
+   {
+      if (m_dimension == 0)
+         throw std::runtime_error("AnytimeSearch: dimension must be positive");
+   }
+
+   Dimension dimension() const
+   { return m_dimension; }
+
+   /**
+    * Returns the index, in the sequence of polynomials coprime with the
+    * modulus, of the \c j-th candidate generator visited.
+    *
+    * The generators are visited with a stride close to \f$(\sqrt{5} -
+    * 1)/2\f$ times the size of the sequence and coprime with it, so that
+    * the first visited generators spread evenly over the sequence and all
+    * are eventually visited.
+    */
+   size_t order(size_t j) const
+   { return size_t((unsigned __int128)j * m_stride % m_genSeq.size()); }
+
+   /**
+    * Returns the state of the running search, or of the last one.
+    */
+   AnytimeSnapshot snapshot() const
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      AnytimeSnapshot s = m_snapshot;
+      s.evaluated = m_evaluated.load(std::memory_order_relaxed);
+      s.elapsedSeconds = m_deadline.elapsedSeconds();
+      return s;
+   }
+
+   /**
+    * Component-by-component construction.
+    *
+    * The time left is divided evenly among the coordinates that remain to
+    * be selected; each coordinate evaluates at least one group of
+    * candidates, so a lattice of full dimension is always returned.
+    */
+   AnytimeSnapshot cbc(const Deadline& deadline)
+   {
+      const size_t n = m_genSeq.size();
+      start(deadline, double(n) * m_dimension);
+      m_eval.reset();
+      const size_t width = Evaluator::bitSliceWidth();
+      std::vector<ModularPoly> group;
+      Real merits[Evaluator::bitSliceWidth()];
+      bool complete = true;
+      for (Dimension j = 0; j < m_dimension; j++) {
+         const Deadline coordinate(deadline.remainingSeconds() / double(m_dimension - j));
+         Parallel::SharedBound bound;
+         ModularPoly best;
+         Real bestMerit = std::numeric_limits<Real>::infinity();
+         size_t i = 0;
+         while (i < n) {
+            group.clear();
+            for (; i < n and group.size() < width; i++)
+               group.push_back(m_genSeq[order(i)]);
+            m_eval.merits(group.begin(), group.end(), merits, m_eval.earlyAbandon() ? &bound : nullptr);
+            for (size_t c = 0; c < group.size(); c++) {
+               if (merits[c] < bestMerit) {
+                  bestMerit = merits[c];
+                  best = group[c];
+               }
+            }
+            bound.improve(bestMerit);
+            m_evaluated.fetch_add(group.size(), std::memory_order_relaxed);
+            if (coordinate.expired())
+               break;
+         }
+         complete = complete and i == n;
+         m_eval.select(best);
+         publish(m_eval.baseLat(), m_eval.baseMerit(), false);
+      }
+      return finish(complete);
+   }
+
+   /**
+    * Exhaustive search of Korobov lattices, with generating vectors
+    * \f$(1, a, a^2, \dots) \bmod P\f$, each one evaluated with early
+    * abandoning against the best merit so far.
+    */
+   AnytimeSnapshot korobov(const Deadline& deadline)
+   {
+      const size_t n = m_genSeq.size();
+      start(deadline, double(n));
+      const ModularPoly one(m_modulus, Poly(1));
+      auto lat = createLatDef(m_eval.baseLat().sizeParam());
+      Parallel::SharedBound bound;
+      size_t i = 0;
+      while (i < n and not deadline.expired()) {
+         const ModularPoly a = m_genSeq[order(i++)];
+         lat.gen().clear();
+         for (ModularPoly g = one; lat.gen().size() < m_dimension; g *= a)
+            lat.gen().push_back(g.toPolyModP());
+         const Real merit = m_eval.evaluate(lat, bound);
+         m_evaluated.fetch_add(1, std::memory_order_relaxed);
+         if (merit < bound.get()) {
+            bound.improve(merit);
+            publish(lat, merit, false);
+         }
+      }
+      return finish(i == n);
+   }
+
+   /**
+    * Random search: generating vectors with components drawn uniformly and
+    * independently among the polynomials coprime with the modulus, each one
+    * evaluated with early abandoning against the best merit so far.
+    *
+    * \param seed          Seed of the random generator.
+    * \param maxSamples    Maximum number of lattices evaluated.
+    */
+   AnytimeSnapshot random(
+         const Deadline& deadline,
+         uint64_t seed = 0,
+         uint64_t maxSamples = std::numeric_limits<uint64_t>::max())
+   {
+      const size_t n = m_genSeq.size();
+      start(deadline, std::pow(double(n), double(m_dimension)));
+      std::mt19937_64 rand(seed);
+      std::uniform_int_distribution<size_t> unif(0, n - 1);
+      auto lat = createLatDef(m_eval.baseLat().sizeParam());
+      Parallel::SharedBound bound;
+      for (uint64_t k = 0; k < maxSamples and not deadline.expired(); k++) {
+         lat.gen().clear();
+         for (Dimension j = 0; j < m_dimension; j++)
+            lat.gen().push_back(m_genSeq[unif(rand)].toPolyModP());
+         const Real merit = m_eval.evaluate(lat, bound);
+         m_evaluated.fetch_add(1, std::memory_order_relaxed);
+         if (merit < bound.get()) {
+            bound.improve(merit);
+            publish(lat, merit, false);
+         }
+      }
+      return finish(false);
+   }
+
+private:
+   Evaluator m_eval;
+   Dimension m_dimension;
+   ModularPoly::ModulusPtr m_modulus;
+   GenSeq::Modular<GenSeq::CoprimePolynomials<>> m_genSeq;
+   size_t m_stride;
+
+   mutable std::mutex m_mutex;
+   AnytimeSnapshot m_snapshot;
+   Deadline m_deadline;
+   std::atomic<uint64_t> m_evaluated;
+
+   static size_t stride(size_t size)
+   {
+      if (size <= 2)
+         return 1;
+      size_t s = size_t(0.6180339887498949 * double(size));
+      while (gcd(s, size) != 1)
+         s++;
+      return s;
+   }
+
+   static size_t gcd(size_t a, size_t b)
+   {
+      while (b) {
+         const size_t r = a % b;
+         a = b;
+         b = r;
+      }
+      return a;
+   }
+
+   void start(const Deadline& deadline, double spaceSize)
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_snapshot = AnytimeSnapshot();
+      m_snapshot.lat = createLatDef(m_eval.baseLat().sizeParam());
+      m_snapshot.spaceSize = spaceSize;
+      m_deadline = deadline;
+      m_evaluated.store(0, std::memory_order_relaxed);
+   }
+
+   void publish(const LatDef<LatType::ORDINARY>& lat, Real merit, bool complete)
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_snapshot.lat = lat;
+      m_snapshot.merit = merit;
+      m_snapshot.complete = complete;
+   }
+
+   AnytimeSnapshot finish(bool complete)
+   {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_snapshot.complete = complete;
+      }
+      return snapshot();
+   }
+};
+
+}
+
+#endif
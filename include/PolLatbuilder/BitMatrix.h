@@ -0,0 +1,195 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__BIT_MATRIX_H
+#define POLLATBUILDER__BIT_MATRIX_H
+
+#include "PolLatbuilder/GeneratingMatrix.h"
+
+#include <vector>
+#include <cstdint>
+#include <ostream>
+
+namespace PolLatBuilder {
+
+/**
+ * Dense matrix over GF(2) with bit-packed rows.
+ *
+ * This is a replacement for <tt>NTL::matrix<GF2></tt> for linear algebra on
+ * generating matrices.  It keeps the same \c size1(), \c size2() and
+ * <tt>operator()(i, j)</tt> interface (with indices starting at 0), but
+ * stores 64 elements per machine word and implements multiplication and
+ * Gaussian elimination with the Method of Four Russians (M4RM and M4RI):
+ * rows are combined through precomputed tables of all linear combinations of
+ * a few rows at a time, so that each word operation processes many elements.
+ *
+ * The element on row \f$i\f$ and column \f$j\f$ is bit \f$j \bmod 64\f$ of
+ * word \f$\lfloor j / 64 \rfloor\f$ of the \f$i\f$-th row.
+ */
+class BitMatrix {
+public:
+   typedef long size_type;
+   typedef uint64_t word_type;
+
+   /**
+    * Proxy to a mutable element.
+    */
+   class reference {
+   public:
+      reference(word_type& word, word_type mask): m_word(&word), m_mask(mask) {}
+      operator bool() const { return *m_word & m_mask; }
+      reference& operator=(bool x) { if (x) *m_word |= m_mask; else *m_word &= ~m_mask; return *this; }
+      reference& operator=(const reference& other) { return operator=(bool(other)); }
+      reference& operator^=(bool x) { if (x) *m_word ^= m_mask; return *this; }
+   private:
+      word_type* m_word;
+      word_type m_mask;
+   };
+
+   /**
+    * Constructor for a zero matrix.
+    */
+   BitMatrix(size_type size1 = 0, size_type size2 = 0)
+   { resize(size1, size2); }
+
+   /**
+    * Conversion from a generating matrix.
+    */
+   explicit BitMatrix(const GeneratingMatrix& mat);
+
+   /**
+    * Sets the matrix dimensions to (size1, size2) and all elements to zero.
+    */
+   void resize(size_type size1, size_type size2)
+   {
+      m_size1 = size1;
+      m_size2 = size2;
+      m_wordsPerRow = (size2 + 63) / 64;
+      m_data.assign(m_size1 * m_wordsPerRow, 0);
+   }
+
+   /**
+    * Releases space and sets the dimensions to zero.
+    */
+   void clear()
+   { resize(0, 0); }
+
+   /**
+    * Returns the number of rows.
+    */
+   size_type size1() const
+   { return m_size1; }
+
+   /**
+    * Returns the number of columns.
+    */
+   size_type size2() const
+   { return m_size2; }
+
+   /**
+    * Returns the element on row \c i and column \c j.
+    */
+   bool operator()(size_type i, size_type j) const
+   { return (row(i)[j / 64] >> (j % 64)) & 1; }
+
+   /// \copydoc operator()()
+   reference operator()(size_type i, size_type j)
+   { return reference(row(i)[j / 64], word_type(1) << (j % 64)); }
+
+   /**
+    * Returns the number of words per row.
+    */
+   size_type wordsPerRow() const
+   { return m_wordsPerRow; }
+
+   /**
+    * Returns a pointer to the packed words of row \c i.
+    */
+   word_type* row(size_type i)
+   { return m_data.data() + i * m_wordsPerRow; }
+
+   /// \copydoc row()
+   const word_type* row(size_type i) const
+   { return m_data.data() + i * m_wordsPerRow; }
+
+   /**
+    * Swaps rows \c i and \c k.
+    */
+   void swapRows(size_type i, size_type k);
+
+   /**
+    * Adds row \c k to row \c i.
+    */
+   void addRow(size_type i, size_type k)
+   { addRow(row(i), row(k), 0); }
+
+   /**
+    * Returns the transpose of this matrix.
+    */
+   BitMatrix transpose() const;
+
+   /**
+    * Reduces this matrix to row echelon form with the Method of Four Russians
+    * Inversion (M4RI) and returns its rank.
+    *
+    * \param reduced    If \c true, the reduced row echelon form is computed.
+    */
+   size_type echelonize(bool reduced = false);
+
+   /**
+    * Returns the rank of this matrix.
+    */
+   size_type rank() const;
+
+   bool operator==(const BitMatrix& other) const
+   { return m_size1 == other.m_size1 and m_size2 == other.m_size2 and m_data == other.m_data; }
+
+   bool operator!=(const BitMatrix& other) const
+   { return not operator==(other); }
+
+private:
+   size_type m_size1;
+   size_type m_size2;
+   size_type m_wordsPerRow;
+   std::vector<word_type> m_data;
+
+   /// Adds \c src to \c dest, starting from word \c first.
+   void addRow(word_type* dest, const word_type* src, size_type first) const
+   {
+      for (size_type w = first; w < m_wordsPerRow; w++)
+         dest[w] ^= src[w];
+   }
+
+   /// Gaussian elimination on the columns [c, c + k) from row r.
+   size_type gaussSubmatrix(size_type r, size_type c, size_type k, std::vector<size_type>& pivots);
+
+   friend BitMatrix operator*(const BitMatrix&, const BitMatrix&);
+};
+
+/**
+ * Returns the product of \c a and \c b, computed with the Method of Four
+ * Russians for multiplication (M4RM).
+ */
+BitMatrix operator*(const BitMatrix& a, const BitMatrix& b);
+
+/**
+ * Formats \c mat as rows of 0s and 1s and outputs it to \c os.
+ */
+std::ostream& operator<<(std::ostream& os, const BitMatrix& mat);
+
+}
+
+#endif
@@ -0,0 +1,48 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__FWHT_H
+#define POLLATBUILDER__FWHT_H
+
+#include "PolLatbuilder/Types.h"
+
+#include <cstddef>
+
+namespace PolLatBuilder {
+
+/**
+ * Replaces the \c n values of \c data with their (unnormalized) Walsh-Hadamard
+ * transform \f$\hat a(k) = \sum_y a(y) (-1)^{k \cdot y}\f$, where \f$k \cdot
+ * y\f$ is the parity of the bitwise AND of \f$k\f$ and \f$y\f$.
+ *
+ * The transform is computed in place with \f$n \log_2 n\f$ additions.  The
+ * first stages are applied block by block on blocks that fit in the L1 cache,
+ * and the remaining stages are applied two at a time, so that the data is
+ * swept from memory about \f$(\log_2 n - 12) / 2\f$ times instead of \f$\log_2
+ * n\f$ times.
+ *
+ * \param n    Length of \c data; must be a power of 2, or 0, in which case
+ *             nothing is done.
+ */
+void fwht(Real* data, size_t n);
+
+/// \copydoc fwht()
+inline void fwht(RealVector& data)
+{ fwht(data.data(), data.size()); }
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__FUNCTOR__ACCUMULATOR_H
+#define POLLATBUILDER__FUNCTOR__ACCUMULATOR_H
+
+/** \file
+ * Accumulators that combine the contributions of the coordinates to a figure
+ * of merit.
+ *
+ * An accumulator is a binary functor, nondecreasing in both arguments, with
+ * a static method <tt>maxOperand(x, z)</tt> that returns the largest \c y
+ * such that \c acc(x, y) does not exceed \c z (minus infinity if there is
+ * none).  The latter is used to prune evaluations early.
+ */
+
+#include "PolLatbuilder/Types.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace PolLatBuilder { namespace Functor {
+
+/**
+ * Sum-type figures of merit: the contributions are added.
+ */
+struct Sum {
+   static std::string name()
+   { return "sum"; }
+
+   Real operator()(Real x, Real y) const
+   { return x + y; }
+
+   static Real maxOperand(Real x, Real z)
+   { return z - x; }
+};
+
+/**
+ * Max-type figures of merit: the largest contribution is kept.
+ */
+struct Max {
+   static std::string name()
+   { return "max"; }
+
+   Real operator()(Real x, Real y) const
+   { return std::max(x, y); }
+
+   static Real maxOperand(Real x, Real z)
+   { return x <= z ? z : -std::numeric_limits<Real>::infinity(); }
+};
+
+}}
+
+#endif
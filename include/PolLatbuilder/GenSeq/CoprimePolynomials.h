@@ -134,9 +134,21 @@ public:
 
    /**
     * Returns the element at index \c i.
+    *
+    * The result is converted to the current PolyModP context, which must
+    * have polynomial() as its modulus.
     */
    value_type operator[](size_type i) const;
 
+   /**
+    * Returns the representative of degree smaller than that of polynomial()
+    * of the element at index \c i.
+    *
+    * Contrary to operator[](), this does not depend on the PolyModP context,
+    * and can be used with GenSeq::Modular.
+    */
+   Poly residue(size_type i) const;
+
 private:
    template <PolLatBuilder::Compress, class> friend class CoprimePolynomials;
 
@@ -191,18 +203,23 @@ CoprimePolynomials<COMPRESS, TRAV>::CoprimePolynomials(
 template <Compress COMPRESS, class TRAV>
 auto CoprimePolynomials<COMPRESS, TRAV>::operator[](size_type i) const -> value_type
 {
-   value_type ret ;
-   
+   return Compress::compressIndex(conv<value_type>(residue(i)), polynomial());
+}
+
+template <Compress COMPRESS, class TRAV>
+Poly CoprimePolynomials<COMPRESS, TRAV>::residue(size_type i) const
+{
+   Poly ret;
+
    for (const auto& e : m_basis) {
       const ldiv_t qr = ldiv(i, e.totient);
       i = qr.quot;
       Poly Q = intToPoly(qr.rem / e.leap);
       Poly R = intToPoly(qr.rem % e.leap + 1);
-      ret += conv <value_type> ((e.irreductible_poly * Q + R) * e.elem);
+      ret += (e.irreductible_poly * Q + R) * e.elem;
    }
-   
-   return Compress::compressIndex(ret , polynomial());
-   
+
+   return ret % m_polynomial;
 }
 
 }}
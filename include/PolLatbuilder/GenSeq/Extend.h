@@ -0,0 +1,199 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__GENSEQ__EXTEND_H
+#define POLLATBUILDER__GENSEQ__EXTEND_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/Util.h"
+#include "PolLatbuilder/Traversal.h"
+#include "PolLatbuilder/GenSeq/CoprimePolynomials.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace PolLatBuilder { namespace GenSeq {
+
+/**
+ * Sequence of generator values for extending a polynomial lattice rule in
+ * number of points.
+ *
+ * For a base rule with modulus \f$P\f$ and generator \f$g\f$ coprime with
+ * \f$P\f$, and a multiple \f$P' = PQ\f$ of \f$P\f$, the sequence contains
+ * the generators \f$g' = g + P t \bmod P'\f$, with \f$\deg t < \deg Q\f$,
+ * that are coprime with \f$P'\f$, i.e., the elements of
+ * CoprimePolynomials for \f$P'\f$ that reduce to \f$g\f$ modulo \f$P\f$.
+ *
+ * Write \f$Q = Q_1 R\f$, where \f$R\f$ is the largest divisor of
+ * \f$Q\f$ coprime with \f$P\f$.  Since \f$g\f$ is coprime with the
+ * factors of \f$P\f$ and \f$Q_1\f$, \f$g'\f$ is coprime with \f$P'\f$
+ * if and only if \f$g + P t\f$ is a unit \f$u\f$ modulo \f$R\f$.  The
+ * \f$i\f$-th element thus uses \f$t = R a + P^{-1} (u - g) \bmod R\f$,
+ * where \f$u\f$ is element \f$i \bmod \varphi(R)\f$ of
+ * CoprimePolynomials for \f$R\f$ and \f$a\f$ is the polynomial whose
+ * binary representation is \f$\lfloor i / \varphi(R) \rfloor\f$ (see
+ * intToPoly()).  The sequence has \f$2^{\deg Q_1} \varphi(R)\f$
+ * elements; if \f$R = 1\f$, as for \f$P = x^m\f$ and \f$P' =
+ * x^{m+1}\f$, the \f$i\f$-th element simply uses the polynomial \f$t\f$
+ * whose binary representation is \f$i\f$.
+ *
+ * The values are PolyModP elements for the current PolyModP context, which
+ * must be \f$P'\f$.
+ *
+ * \tparam TRAV      Traversal policy.
+ */
+template <class TRAV = Traversal::Forward>
+class Extend :
+   public Traversal::Policy<Extend<TRAV>, TRAV> {
+
+   typedef Extend<TRAV> self_type;
+   typedef Traversal::Policy<self_type, TRAV> TraversalPolicy;
+
+public:
+   typedef PolyModP value_type;
+   typedef size_t size_type;
+   typedef TRAV Traversal;
+
+   static std::string name()
+   { return std::string("extend / ") + Traversal::name(); }
+
+   /**
+    * Constructor.
+    *
+    * \param modulus       Modulus \f$P'\f$ of the extended rule.
+    * \param baseModulus   Modulus \f$P\f$ of the base rule; must divide
+    *                      \c modulus.
+    * \param baseGen       Generator \f$g\f$ of the base rule; must be
+    *                      coprime with \c baseModulus.
+    * \param trav          Traversal instance.
+    */
+   Extend(Poly modulus, Poly baseModulus, Poly baseGen, Traversal trav = Traversal()):
+      TraversalPolicy(std::move(trav)),
+      m_modulus(std::move(modulus)),
+      m_baseModulus(std::move(baseModulus)),
+      m_baseGen(),
+      m_size(0)
+   {
+      if (IsZero(m_baseModulus) or not IsZero(m_modulus % m_baseModulus))
+         throw std::runtime_error("GenSeq::Extend: the base modulus must divide the modulus");
+      m_baseGen = baseGen % m_baseModulus;
+      if (deg(GCD(m_baseGen, m_baseModulus)) != 0)
+         throw std::runtime_error("GenSeq::Extend: the base generator must be coprime with the base modulus");
+
+      // R: the largest divisor of Q coprime with P
+      m_coprimePart = m_modulus / m_baseModulus;
+      for (Poly d = GCD(m_coprimePart, m_baseModulus); deg(d) > 0; d = GCD(m_coprimePart, m_baseModulus))
+         m_coprimePart = m_coprimePart / d;
+      m_size = size_type(1) << (deg(m_modulus) - deg(m_baseModulus) - deg(m_coprimePart));
+      if (deg(m_coprimePart) > 0) {
+         m_units = CoprimePolynomials<>(m_coprimePart);
+         m_size *= m_units.size();
+         Poly d, t;
+         XGCD(d, m_inverse, t, m_baseModulus % m_coprimePart, m_coprimePart);
+      }
+   }
+
+   /**
+    * Cross-traversal copy-constructor.
+    */
+   template <class TRAV2>
+   Extend(const Extend<TRAV2>& other, Traversal trav = Traversal()):
+      TraversalPolicy(std::move(trav)),
+      m_modulus(other.m_modulus),
+      m_baseModulus(other.m_baseModulus),
+      m_baseGen(other.m_baseGen),
+      m_coprimePart(other.m_coprimePart),
+      m_units(other.m_units),
+      m_inverse(other.m_inverse),
+      m_size(other.m_size)
+   {}
+
+   /**
+    * Rebinds the traversal type.
+    */
+   template <class TRAV2>
+   struct RebindTraversal {
+      typedef Extend<TRAV2> Type;
+   };
+
+   /**
+    * Returns a copy of this object, but using a different traversal policy.
+    */
+   template <class TRAV2>
+   typename RebindTraversal<TRAV2>::Type rebind(TRAV2 trav) const
+   { return typename RebindTraversal<TRAV2>::Type{*this, std::move(trav)}; }
+
+   /**
+    * Returns the modulus of the extended rule.
+    */
+   const Poly& modulus() const
+   { return m_modulus; }
+
+   /**
+    * Returns the modulus of the base rule.
+    */
+   const Poly& baseModulus() const
+   { return m_baseModulus; }
+
+   /**
+    * Returns the generator of the base rule, reduced modulo baseModulus().
+    */
+   const Poly& baseGen() const
+   { return m_baseGen; }
+
+   /**
+    * Returns the size of the sequence.
+    */
+   size_type size() const
+   { return m_size; }
+
+   /**
+    * Returns the element at index \c i.
+    */
+   value_type operator[](size_type i) const
+   { return conv<value_type>(residue(i)); }
+
+   /**
+    * Returns the representative of degree smaller than that of modulus() of
+    * the element at index \c i, independently of the PolyModP context.
+    */
+   Poly residue(size_type i) const
+   {
+      if (deg(m_coprimePart) <= 0)
+         return m_baseGen + m_baseModulus * intToPoly(i);
+      const Poly u = m_units.residue(i % m_units.size());
+      const Poly b = m_inverse * (u - m_baseGen) % m_coprimePart;
+      return m_baseGen + m_baseModulus * (m_coprimePart * intToPoly(i / m_units.size()) + b);
+   }
+
+private:
+   template <class> friend class Extend;
+
+   Poly m_modulus;
+   Poly m_baseModulus;
+   Poly m_baseGen;
+   /// largest divisor of modulus() / baseModulus() coprime with baseModulus()
+   Poly m_coprimePart;
+   /// units modulo m_coprimePart, if its degree is positive
+   CoprimePolynomials<> m_units;
+   /// inverse of baseModulus() modulo m_coprimePart
+   Poly m_inverse;
+   size_type m_size;
+};
+
+}}
+
+#endif
@@ -0,0 +1,130 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__GENSEQ__MODULAR_H
+#define POLLATBUILDER__GENSEQ__MODULAR_H
+
+#include "PolLatbuilder/ModularPoly.h"
+#include "PolLatbuilder/Traversal.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace PolLatBuilder { namespace GenSeq {
+
+/**
+ * Sequence of ModularPoly values with the same elements as another
+ * generator sequence.
+ *
+ * The base sequence must provide a <tt>residue(i)</tt> member function, as
+ * CoprimePolynomials and Extend do, so that the elements are computed
+ * without the PolyModP context: sequences with different moduli can thus
+ * be traversed concurrently by any thread.
+ *
+ * \tparam SEQ       Type of base sequence.
+ * \tparam TRAV      Traversal policy.
+ */
+template <class SEQ, class TRAV = Traversal::Forward>
+class Modular :
+   public Traversal::Policy<Modular<SEQ, TRAV>, TRAV> {
+
+   typedef Modular<SEQ, TRAV> self_type;
+   typedef Traversal::Policy<self_type, TRAV> TraversalPolicy;
+
+public:
+   typedef SEQ Base;
+   typedef ModularPoly value_type;
+   typedef typename Base::size_type size_type;
+   typedef TRAV Traversal;
+
+   static std::string name()
+   { return std::string("modular / ") + Base::name() + " / " + Traversal::name(); }
+
+   /**
+    * Constructor.
+    *
+    * \param modulus    Modulus of the elements of \c base.
+    * \param base       Base sequence.
+    * \param trav       Traversal instance.
+    */
+   Modular(ModularPoly::ModulusPtr modulus, Base base, Traversal trav = Traversal()):
+      TraversalPolicy(std::move(trav)),
+      m_modulus(std::move(modulus)),
+      m_base(std::move(base))
+   {
+      if (not m_modulus)
+         throw std::runtime_error("GenSeq::Modular: null modulus");
+   }
+
+   /**
+    * Cross-traversal copy-constructor.
+    */
+   template <class TRAV2>
+   Modular(const Modular<SEQ, TRAV2>& other, Traversal trav = Traversal()):
+      TraversalPolicy(std::move(trav)),
+      m_modulus(other.m_modulus),
+      m_base(other.m_base)
+   {}
+
+   /**
+    * Rebinds the traversal type.
+    */
+   template <class TRAV2>
+   struct RebindTraversal {
+      typedef Modular<SEQ, TRAV2> Type;
+   };
+
+   /**
+    * Returns a copy of this object, but using a different traversal policy.
+    */
+   template <class TRAV2>
+   typename RebindTraversal<TRAV2>::Type rebind(TRAV2 trav) const
+   { return typename RebindTraversal<TRAV2>::Type{*this, std::move(trav)}; }
+
+   /**
+    * Returns the modulus descriptor.
+    */
+   const ModularPoly::ModulusPtr& modulus() const
+   { return m_modulus; }
+
+   /**
+    * Returns the base sequence.
+    */
+   const Base& base() const
+   { return m_base; }
+
+   /**
+    * Returns the size of the sequence.
+    */
+   size_type size() const
+   { return m_base.size(); }
+
+   /**
+    * Returns the element at index \c i.
+    */
+   value_type operator[](size_type i) const
+   { return ModularPoly::fromReduced(m_modulus, m_base.residue(i)); }
+
+private:
+   template <class, class> friend class Modular;
+
+   ModularPoly::ModulusPtr m_modulus;
+   Base m_base;
+};
+
+}}
+
+#endif
@@ -0,0 +1,219 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__GENSEQ__POWER_SEQ_H
+#define POLLATBUILDER__GENSEQ__POWER_SEQ_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/Util.h"
+
+#include <boost/iterator/iterator_adaptor.hpp>
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+
+namespace PolLatBuilder { namespace GenSeq {
+
+/**
+ * Sequence of powers \f$a^k \bmod P\f$ of the values \f$a\f$ of another
+ * sequence, for a fixed exponent \f$k\f$.
+ *
+ * The modulus is that of the current PolyModP context.  The sequence can
+ * optionally skip the base elements flagged in a selection mask shared by
+ * several sequences, so that the sequences of the different powers used by
+ * LatSeq::Korobov stay aligned.
+ *
+ * \tparam SEQ       Type of base sequence of PolyModP values.
+ */
+template <class SEQ>
+class PowerSeq {
+public:
+   typedef SEQ Base;
+   typedef PolyModP value_type;
+   typedef typename Base::size_type size_type;
+
+   /**
+    * Selection mask: element \f$i\f$ of the base sequence is skipped if
+    * entry \f$i\f$ is \c true.
+    */
+   typedef std::vector<bool> SkipMask;
+
+   static std::string name()
+   { return "power sequence / " + Base::name(); }
+
+   /**
+    * Constructor.
+    *
+    * \param base       Base sequence.
+    * \param power      Exponent \f$k\f$.
+    * \param skip       Selection mask indexed like the base sequence, or
+    *                   \c nullptr to keep all elements.
+    */
+   PowerSeq(Base base, long power, std::shared_ptr<const SkipMask> skip = nullptr):
+      m_base(std::move(base)),
+      m_power(power),
+      m_skip(std::move(skip))
+   {}
+
+   /**
+    * Returns the base sequence.
+    */
+   const Base& base() const
+   { return m_base; }
+
+   /**
+    * Returns the exponent.
+    */
+   long power() const
+   { return m_power; }
+
+   /**
+    * Returns the selection mask, or \c nullptr if all elements are kept.
+    */
+   const std::shared_ptr<const SkipMask>& skipMask() const
+   { return m_skip; }
+
+   /**
+    * Returns \c true if element \c i of the base sequence is skipped.
+    */
+   bool skipped(size_type i) const
+   { return m_skip and i < m_skip->size() and (*m_skip)[i]; }
+
+   /**
+    * Returns the selection mask that keeps one representative of each class
+    * of values \f$\{a, a^{-1}\}\f$ in \c base: element \f$i\f$ is skipped if
+    * \f$a_i\f$ or its inverse modulo \f$P\f$ occurs at a smaller index.
+    *
+    * The base sequence must be indexable.  Non-invertible values are only
+    * skipped if they repeat.
+    */
+   static std::shared_ptr<const SkipMask> inverseMask(const Base& base)
+   {
+      auto mask = std::make_shared<SkipMask>(base.size(), false);
+      // first index of each value, keyed by its binary representation
+      std::map<Modulus, size_type> seen;
+      for (size_type i = 0; i < base.size(); i++) {
+         const value_type a = base[i];
+         const Modulus key = polyToInt(rep(a));
+         if (seen.count(key)) {
+            (*mask)[i] = true;
+            continue;
+         }
+         seen.emplace(key, i);
+         Poly d, s, t;
+         XGCD(d, s, t, rep(a), PolyModP::modulus());
+         if (IsOne(d)) {
+            const Modulus inverse = polyToInt(s % PolyModP::modulus());
+            if (seen.count(inverse) and seen[inverse] < i)
+               (*mask)[i] = true;
+         }
+      }
+      return mask;
+   }
+
+private:
+   Base m_base;
+   long m_power;
+   std::shared_ptr<const SkipMask> m_skip;
+
+public:
+
+   /**
+    * Constant iterator.
+    */
+   class const_iterator : public boost::iterators::iterator_adaptor<const_iterator,
+      typename Base::const_iterator,
+      const value_type,
+      boost::iterators::forward_traversal_tag>
+   {
+   public:
+      struct end_tag {};
+
+      const_iterator():
+         const_iterator::iterator_adaptor_(),
+         m_seq(nullptr)
+      {}
+
+      explicit const_iterator(const PowerSeq& seq):
+         const_iterator::iterator_adaptor_(seq.base().begin()),
+         m_seq(&seq)
+      { skip(); }
+
+      const_iterator(const PowerSeq& seq, end_tag):
+         const_iterator::iterator_adaptor_(seq.base().end()),
+         m_seq(&seq)
+      { }
+
+      const PowerSeq& seq() const
+      { return *m_seq; }
+
+      /**
+       * Returns the index of the current element in the base sequence.
+       */
+      size_type index() const
+      { return this->base_reference().index(); }
+
+   private:
+      friend class boost::iterators::iterator_core_access;
+
+      void increment()
+      { ++this->base_reference(); skip(); }
+
+      /// Moves past the skipped elements and updates the value.
+      void skip()
+      {
+         const auto end = m_seq->base().end();
+         while (this->base_reference() != end and m_seq->skipped(index()))
+            ++this->base_reference();
+         if (this->base_reference() != end)
+            m_value = NTL::power(*this->base_reference(), m_seq->power());
+      }
+
+      bool equal(const const_iterator& other) const
+      { return m_seq == other.m_seq and this->base_reference() == other.base_reference(); }
+
+      const value_type& dereference() const
+      {
+#ifndef NDEBUG
+         if (this->base_reference() == m_seq->base().end())
+            throw std::runtime_error("GenSeq::PowerSeq: dereferencing past end of sequence");
+#endif
+         return m_value;
+      }
+
+   private:
+      const PowerSeq* m_seq;
+      value_type m_value;
+   };
+
+   /**
+    * Returns an iterator pointing to the first element in the sequence.
+    */
+   const_iterator begin() const
+   { return const_iterator(*this); }
+
+   /**
+    * Returns an iterator pointing past the last element in the sequence.
+    */
+   const_iterator end() const
+   { return const_iterator(*this, typename const_iterator::end_tag{}); }
+};
+
+}}
+
+#endif
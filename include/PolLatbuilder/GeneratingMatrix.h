@@ -0,0 +1,117 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__GENERATING_MATRIX_H
+#define POLLATBUILDER__GENERATING_MATRIX_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/LatDef.h"
+
+#include <vector>
+#include <cstdint>
+#include <ostream>
+
+namespace PolLatBuilder {
+
+/**
+ * Generating matrix of a digital net in base 2, with bit-packed columns.
+ *
+ * The matrix has at most 64 rows.  Each column is stored in a 64-bit word,
+ * with row 0 as the most significant of size1() bits, so that the digits of
+ * the point associated to the digit vector \f$(k_0, k_1, \dots)\f$ are the XOR
+ * of the columns \f$s\f$ for which \f$k_s = 1\f$, read as a binary fraction.
+ */
+class GeneratingMatrix {
+public:
+   typedef long size_type;
+
+   /**
+    * Constructor.
+    *
+    * \param numRows    Number of rows; at most 64.
+    * \param columns    Packed columns.
+    */
+   GeneratingMatrix(size_type numRows = 0, std::vector<uint64_t> columns = std::vector<uint64_t>());
+
+   /**
+    * Returns the number of rows.
+    */
+   size_type size1() const
+   { return m_numRows; }
+
+   /**
+    * Returns the number of columns.
+    */
+   size_type size2() const
+   { return m_columns.size(); }
+
+   /**
+    * Returns the element on row \c i and column \c j.
+    */
+   bool operator()(size_type i, size_type j) const
+   { return (m_columns[j] >> (m_numRows - 1 - i)) & 1; }
+
+   /**
+    * Returns the packed column \c j.
+    */
+   uint64_t column(size_type j) const
+   { return m_columns[j]; }
+
+   /**
+    * Returns all packed columns.
+    */
+   const std::vector<uint64_t>& columns() const
+   { return m_columns; }
+
+   /**
+    * Returns the rows packed in the same format as the columns: bit
+    * \f$size2() - 1 - j\f$ of the \f$i\f$-th word is the element on row
+    * \f$i\f$ and column \f$j\f$.
+    */
+   std::vector<uint64_t> rows() const;
+
+   bool operator==(const GeneratingMatrix& other) const
+   { return m_numRows == other.m_numRows and m_columns == other.m_columns; }
+
+   bool operator!=(const GeneratingMatrix& other) const
+   { return not operator==(other); }
+
+private:
+   size_type m_numRows;
+   std::vector<uint64_t> m_columns;
+};
+
+/**
+ * Formats \c mat as rows of 0s and 1s and outputs it to \c os.
+ */
+std::ostream& operator<<(std::ostream& os, const GeneratingMatrix& mat);
+
+/**
+ * Returns the generating matrices of the polynomial lattice \c lat, one per
+ * coordinate.
+ *
+ * For a modulus \f$P\f$ of degree \f$m\f$, the \f$j\f$-th matrix is the
+ * \f$m \times m\f$ Hankel matrix \f$(u^{(j)}_{r+s+1})\f$ formed by the
+ * coefficients of the Laurent series expansion of \f$g_j(x)/P(x)\f$.  The
+ * expansion is computed on machine words (see laurentColumns()), so that the
+ * total cost is \f$O(d m)\f$ word operations and storage for \f$d\f$
+ * coordinates.  \f$m\f$ must be at most 63.
+ */
+std::vector<GeneratingMatrix> generatingMatrices(const LatDef<LatType::ORDINARY>& lat);
+
+}
+
+#endif
@@ -17,6 +17,8 @@
 #ifndef POLLATBUILDER__INDEXED_ITERATOR_H
 #define POLLATBUILDER__INDEXED_ITERATOR_H
 
+#include "PolLatbuilder/Util.h"
+
 #include <boost/iterator/iterator_facade.hpp>
 #include <random>
 
@@ -182,6 +184,118 @@ private:
    value_type m_value;
 };
 
+
+/**
+ * Immutable stratified indexed iterator.
+ *
+ * Visits the indices in \f$[0, n)\f$, where \f$n\f$ is the size of the
+ * sequence, in the order of the van der Corput sequence in base 2: the
+ * \f$k\f$-th visited index is the \f$k\f$-th integer smaller than \f$n\f$ in
+ * the sequence of the bit-reversed values of \f$0, 1, 2, \dots\f$ on
+ * \f$\lceil \log_2 n \rceil\f$ bits.  The first \f$2^b\f$ values of that
+ * sequence fall in distinct intervals of length \f$2^{-b}\f$ of the
+ * range, so any prefix of the traversal is spread over the whole sequence,
+ * and at most half of the values are skipped.
+ *
+ * \tparam SEQ Type of sequence to which the iterator points.  Must implement
+ *             value_type operator[](SEQ::size_type).
+ */
+template <typename SEQ>
+class Stratified : public boost::iterators::iterator_facade<
+   Stratified<SEQ>,
+   const typename SEQ::value_type,
+   boost::iterators::forward_traversal_tag>
+{
+public:
+   typedef SEQ Seq;
+   typedef typename Seq::value_type value_type;
+   typedef typename Seq::size_type size_type;
+
+   struct end_tag {};
+
+   Stratified():
+      Stratified::iterator_facade_(),
+      m_seq(nullptr),
+      m_count(0),
+      m_code(0),
+      m_bits(0),
+      m_index(0)
+   {}
+
+   explicit Stratified(const Seq& seq):
+      Stratified::iterator_facade_(),
+      m_seq(&seq),
+      m_count(0),
+      m_code(0),
+      m_bits(0),
+      m_index(0)
+   {
+      while (m_bits < 63 and (uint64_t(1) << m_bits) < uint64_t(seq.size()))
+         m_bits++;
+      updateValue();
+   }
+
+   /**
+    * Constructor for the iterator past the \c count first visited elements.
+    */
+   Stratified(const Seq& seq, size_type count, end_tag):
+      Stratified::iterator_facade_(),
+      m_seq(&seq),
+      m_count(count),
+      m_code(0),
+      m_bits(0),
+      m_index(0)
+   {}
+
+   /**
+    * Returns the index of the element in the sequence this iterator is
+    * currently pointing to.
+    */
+   size_type index() const
+   { return m_index; }
+
+   /**
+    * Returns the number of elements visited before the current one.
+    */
+   size_type count() const
+   { return m_count; }
+
+   /**
+    * Returns a reference to the sequence.
+    */
+   const Seq& seq() const
+   { return *m_seq; }
+
+private:
+   friend class boost::iterators::iterator_core_access;
+
+   void updateValue()
+   { m_value = index() < seq().size() ? seq()[index()] : value_type(); }
+
+   void increment()
+   {
+      ++m_count;
+      do
+         m_index = size_type(reverseBits(++m_code, m_bits));
+      while (m_index >= seq().size() and m_code >> m_bits == 0);
+      updateValue();
+   }
+
+   bool equal(const Stratified& other) const
+   { return m_seq == other.m_seq and m_count == other.m_count; }
+
+   typename Stratified::reference dereference() const
+   { return m_value; }
+
+private:
+   const Seq* m_seq;
+   size_type m_count;
+   uint64_t m_code;
+   unsigned m_bits;
+   size_type m_index;
+   value_type m_value;
+};
+
 }}
 
 #endif
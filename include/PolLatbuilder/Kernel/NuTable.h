@@ -0,0 +1,172 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__KERNEL__NU_TABLE_H
+#define POLLATBUILDER__KERNEL__NU_TABLE_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/Util.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+namespace PolLatBuilder { namespace Kernel {
+
+/**
+ * Precomputed values of a kernel that depends on a point only through the
+ * position \f$\nu\f$ of its first nonzero digit.
+ *
+ * For points with \f$m\f$ digits packed in the low bits of a word, with the
+ * first digit as the most significant one, \f$\nu = 64 - m + 1 -
+ * \mathrm{clz}(x)\f$ for \f$x \neq 0\f$, where \f$\mathrm{clz}\f$ counts the
+ * leading zero bits of the 64-bit word.  The table is therefore indexed
+ * directly by the leading-zero count, with index 64 for \f$x = 0\f$, and a
+ * kernel evaluation is a count-leading-zeros instruction and a load.
+ *
+ * The array operations evaluate() and dot() use AVX-512 (vector leading-zero
+ * count and gather) or AVX2 code paths when the processor supports them; the
+ * path is chosen at run time when the table is constructed.  The AVX2 path
+ * obtains the leading-zero count from the exponent of the points converted
+ * to floating point, and is used only for at most 52 digits.  The
+ * bit-sliced evaluation bitSlicedDot() is limited to 32 digits.
+ */
+class NuTable {
+public:
+   /**
+    * Constructor.
+    *
+    * \param kernel     Kernel; must provide <tt>Real valueAt(unsigned nu)
+    *                   const</tt>, with \c nu = 0 for the origin.
+    * \param numDigits  Number of digits \f$m\f$ of the points, at most 63.
+    */
+   template <class KERNEL>
+   NuTable(const KERNEL& kernel, unsigned numDigits):
+      m_numDigits(numDigits)
+   {
+      if (numDigits < 1 or numDigits > 63)
+         throw std::runtime_error("NuTable: number of digits must be in 1..63");
+      for (unsigned c = 0; c < 64; c++)
+         m_values[c] = c < 64 - numDigits ? 0.0 : kernel.valueAt(c - (64 - numDigits) + 1);
+      m_values[64] = kernel.valueAt(0);
+      init();
+   }
+
+   /**
+    * Returns the number of digits of the points.
+    */
+   unsigned numDigits() const
+   { return m_numDigits; }
+
+   /**
+    * Returns the kernel value for the point with packed digits \c digits.
+    */
+   Real operator()(uint64_t digits) const
+   { return m_values[leadingZeros(digits)]; }
+
+   /**
+    * Returns the kernel value for the points whose first nonzero digit is at
+    * position \c nu, or for the origin if \c nu is 0.
+    */
+   Real valueAt(unsigned nu) const
+   { return m_values[nu == 0 ? 64 : 64 - m_numDigits + nu - 1]; }
+
+   /**
+    * Returns the table, indexed by leading-zero count.
+    */
+   const Real* data() const
+   { return m_values; }
+
+   /**
+    * Writes the kernel values for the \c n points with packed digits
+    * \c digits to \c out.
+    */
+   void evaluate(const uint64_t* digits, size_t n, Real* out) const
+   { m_evaluate(m_values, digits, n, out); }
+
+   /**
+    * Returns \f$\sum_i w_i \omega(x_i)\f$ for the \c n points with packed
+    * digits \c digits and the weights \c weights.
+    */
+   Real dot(const uint64_t* digits, const Real* weights, size_t n) const
+   { return m_dot(m_values, digits, weights, n); }
+
+   /**
+    * Bit-sliced counterpart of dot() for up to 64 point sets at once.
+    *
+    * The digits of the point sets are stored transposed: bit \f$c\f$ of
+    * word \f$r\f$ of \c state is bit \f$r\f$ of the packed digits of point
+    * set \f$c\f$.  The points of Gray-code indices \c first to <tt>first +
+    * count - 1</tt> are visited by XORing word \f$r\f$ of \c state with word
+    * <tt>slices[b * maxBitSlicedDigits() + r]</tt> to move to a point of
+    * index with \f$b\f$ trailing zeros, and <tt>sums[c]</tt> is incremented by the
+    * weighted sum of the kernel values of point set \f$c\f$.
+    *
+    * \param slices      Transposed digit columns, padded with zeros to
+    *                    maxBitSlicedDigits() words per column.
+    * \param sets        Bit mask of the point sets (bit \f$c\f$ for point set
+    *                    \f$c\f$).
+    * \param state       numDigits() words; the digits of the point of index
+    *                    <tt>first - 1</tt>, or zeros if \c first is 0.  On
+    *                    return, the digits of the last point.
+    * \param first       Gray-code index of the first point.
+    * \param weights     Weights of the \c count points.
+    * \param count       Number of points.
+    * \param sums        Sums, one per point set.
+    */
+   void bitSlicedDot(
+         const uint64_t* slices, uint64_t sets, uint64_t* state,
+         size_t first, const Real* weights, size_t count, Real* sums) const
+   { m_bitSlicedDot(*this, slices, sets, state, first, weights, count, sums); }
+
+   /**
+    * Returns the name of the instruction set used by evaluate() and dot().
+    */
+   const char* instructionSet() const
+   { return m_instructionSet; }
+
+   /**
+    * Returns \c true if bitSlicedDot() uses vector instructions.
+    */
+   bool bitSlicedVectorized() const
+   { return m_bitSlicedVectorized; }
+
+   /**
+    * Returns the maximum number of digits supported by bitSlicedDot().
+    */
+   static constexpr unsigned maxBitSlicedDigits()
+   { return 32; }
+
+private:
+   typedef void (*EvaluateFunction)(const Real*, const uint64_t*, size_t, Real*);
+   typedef Real (*DotFunction)(const Real*, const uint64_t*, const Real*, size_t);
+   typedef void (*BitSlicedDotFunction)(const NuTable&, const uint64_t*, uint64_t, uint64_t*, size_t, const Real*, size_t, Real*);
+
+   unsigned m_numDigits;
+   alignas(64) Real m_values[65];
+   EvaluateFunction m_evaluate;
+   DotFunction m_dot;
+   BitSlicedDotFunction m_bitSlicedDot;
+   bool m_bitSlicedVectorized;
+   const char* m_instructionSet;
+
+   /// Selects the code path for the processor and the number of digits.
+   void init();
+};
+
+}}
+
+#endif
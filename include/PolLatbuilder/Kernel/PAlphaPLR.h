@@ -0,0 +1,103 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__KERNEL__PALPHA_PLR_H
+#define POLLATBUILDER__KERNEL__PALPHA_PLR_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/Util.h"
+#include "PolLatbuilder/Kernel/NuTable.h"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <stdexcept>
+
+namespace PolLatBuilder { namespace Kernel {
+
+/**
+ * Kernel of the \f$\mathcal P_\alpha\f$ figure of merit for polynomial
+ * lattice rules in base 2.
+ *
+ * For \f$x = \sum_{l \geq 1} x_l 2^{-l}\f$, the kernel is the Walsh series
+ * \f[
+ *    \omega_\alpha(x) = \sum_{h \geq 1} 2^{-\alpha \lfloor \log_2 h \rfloor}
+ *    \mathrm{wal}_h(x) =
+ *    \begin{cases}
+ *       \mu_\alpha & \text{if } x = 0, \\
+ *       \mu_\alpha - 2^{(\nu - 1)(1 - \alpha)} (\mu_\alpha + 1)
+ *       & \text{otherwise,}
+ *    \end{cases}
+ * \f]
+ * where \f$\nu\f$ is the position of the first nonzero digit of \f$x\f$ and
+ * \f$\mu_\alpha = 1 / (1 - 2^{1 - \alpha})\f$.  It depends on \f$x\f$ only
+ * through \f$\nu\f$, so evaluations in inner loops go through a NuTable
+ * obtained with table().
+ */
+class PAlphaPLR {
+public:
+   /**
+    * Constructor.
+    *
+    * \param alpha   Smoothness parameter; must be larger than 1.
+    */
+   explicit PAlphaPLR(Real alpha):
+      m_alpha(alpha)
+   {
+      if (m_alpha <= 1.0)
+         throw std::runtime_error("PAlphaPLR: alpha must be larger than 1");
+      m_mu = 1.0 / (1.0 - std::pow(2.0, 1.0 - m_alpha));
+   }
+
+   static std::string name()
+   { return "P-alpha PLR"; }
+
+   /**
+    * Returns the value of \f$\alpha\f$.
+    */
+   Real alpha() const
+   { return m_alpha; }
+
+   /**
+    * Returns the kernel value for points whose first nonzero digit is at
+    * position \c nu, or for the origin if \c nu is 0.
+    */
+   Real valueAt(unsigned nu) const
+   { return nu == 0 ? m_mu : m_mu - std::pow(2.0, (nu - 1.0) * (1.0 - m_alpha)) * (m_mu + 1.0); }
+
+   /**
+    * Returns the kernel value for the point with packed digits \c digits, with
+    * the first of \c numDigits digits as the most significant bit.
+    */
+   Real operator()(uint64_t digits, unsigned numDigits) const
+   { return valueAt(digits ? numDigits - (63 - leadingZeros(digits)) : 0); }
+
+   /**
+    * Returns the table of kernel values for points with \c numDigits digits.
+    *
+    * Tables are computed once per pair (\c numDigits, \f$\alpha\f$) and
+    * shared among all kernel instances and threads.
+    */
+   std::shared_ptr<const NuTable> table(unsigned numDigits) const;
+
+private:
+   Real m_alpha;
+   Real m_mu;
+};
+
+}}
+
+#endif
@@ -34,6 +34,11 @@ namespace LatSeq {
  * components of the generating vectors taken from a user-specified vector of
  * integer sequences, one corresponding to each coordinate.
  *
+ * With the CanonicalCartesianProduct policy, the first component of the
+ * generating vectors stays at the first value of its sequence, so that an
+ * exhaustive search visits a single generating vector out of each class of
+ * vectors that differ by a unit factor and define the same point set.
+ *
  * \tparam LAT       Type of lattice.
  * \tparam GENSEQ    Type of sequence of generator values.
  * \tparam POLICY    See SeqCombiner.
@@ -14,24 +14,31 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#ifndef LATBUILDER__LAT_SEQ__KOROBOV_H
-#define LATBUILDER__LAT_SEQ__KOROBOV_H
+#ifndef POLLATBUILDER__LAT_SEQ__KOROBOV_H
+#define POLLATBUILDER__LAT_SEQ__KOROBOV_H
 
-#include "latbuilder/LatSeq/Combiner.h"
-#include "latbuilder/GenSeq/PowerSeq.h"
-#include "latbuilder/Types.h"
+#include "PolLatbuilder/LatSeq/Combiner.h"
+#include "PolLatbuilder/GenSeq/PowerSeq.h"
+#include "PolLatbuilder/Types.h"
 
 #include <vector>
 
-namespace LatBuilder { namespace LatSeq {
+namespace PolLatBuilder { namespace LatSeq {
 
 /**
- * Sequence of Korobov lattices.
+ * Sequence of Korobov lattices, with generating vectors
+ * \f$(1, a, a^2, \dots, a^{s-1}) \bmod P\f$.
  *
- * \tparam LAT       Type of lattice.
- * \tparam GENSEQ    Type of sequence of sequences of generator values.
+ * Reversing the order of the coordinates of the Korobov lattice with
+ * generator \f$a\f$ and multiplying the generating vector by the unit
+ * \f$a^{-(s-1)}\f$, which does not change the point set, gives the Korobov
+ * lattice with generator \f$a^{-1}\f$.  For figures of merit that are
+ * invariant under this reversal, such as with order-dependent weights or
+ * with equal product weights, the sequence can skip \f$a\f$ when
+ * \f$a^{-1}\f$ has already been visited, which nearly halves the search.
  *
- * \sa GenSeqSeq
+ * \tparam LAT       Type of lattice.
+ * \tparam GENSEQ    Type of sequence of generator values.
  */
 template <LatType LAT, class GENSEQ>
 class Korobov :
@@ -45,31 +52,37 @@ public:
     * Constructor.
     *
     * \param sizeParam     Lattice size parameter.
-    * \param genSeq        Sequence of sequences of generator values.
+    * \param genSeq        Sequence of generator values.
     * \param latDimension  Dimension of the lattices in the sequence.
+    * \param skipInverses  If \c true, skip the generators whose inverse
+    *                      modulo \f$P\f$ was visited before; \c genSeq must
+    *                      then be indexable and the figure of merit invariant
+    *                      under the reversal of the coordinates.
     */
    Korobov(
          const SizeParam<LAT>& sizeParam,
          const GENSEQ& genSeq,
-         Dimension latDimension):
+         Dimension latDimension,
+         bool skipInverses = false):
       Combiner<LAT, GenSeq::PowerSeq<GENSEQ>, Zip>(
             sizeParam,
-            makeGenSeqs(sizeParam, genSeq, latDimension))
+            makeGenSeqs(genSeq, latDimension, skipInverses))
    {}
 
 private:
    static std::vector<GenSeq::PowerSeq<GENSEQ>> makeGenSeqs(
-         const SizeParam<LAT>& sizeParam,
          const GENSEQ& genSeq,
-         Dimension dimension)
+         Dimension dimension,
+         bool skipInverses)
    {
+      const auto skip = skipInverses ? GenSeq::PowerSeq<GENSEQ>::inverseMask(genSeq) : nullptr;
       std::vector<GenSeq::PowerSeq<GENSEQ>> vec;
       vec.reserve(dimension);
       for (unsigned int coord = 0; coord < dimension; coord++)
          vec.push_back(GenSeq::PowerSeq<GENSEQ>{
                genSeq,
                coord,
-               sizeParam.numPoints()});
+               skip});
       return vec;
    }
 };
@@ -80,9 +93,10 @@ Korobov<LAT, GENSEQ>
 korobov(
       const SizeParam<LAT>& size,
       const GENSEQ& genSeqs,
-      Dimension dimension
+      Dimension dimension,
+      bool skipInverses = false
       ) {
-   return Korobov<LAT, GENSEQ>(size, genSeqs, dimension);
+   return Korobov<LAT, GENSEQ>(size, genSeqs, dimension, skipInverses);
 }
 
 }}
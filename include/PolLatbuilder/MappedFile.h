@@ -0,0 +1,135 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__MAPPED_FILE_H
+#define POLLATBUILDER__MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace PolLatBuilder {
+
+/**
+ * Read-only memory mapping of a whole file.
+ *
+ * The file is mapped privately, so that its pages are read from disk on
+ * demand and shared with the page cache, without an intermediate copy in
+ * user space.  The mapping is released by the destructor.
+ */
+class MappedFile {
+public:
+   /**
+    * Access patterns that can be announced to the kernel with advise().
+    */
+   enum class Access { NORMAL, SEQUENTIAL, RANDOM, WILLNEED, DONTNEED };
+
+   /**
+    * Maps the file at \c path.
+    *
+    * Throws \c std::runtime_error if the file cannot be opened or mapped.
+    */
+   explicit MappedFile(const std::string& path);
+
+   MappedFile(MappedFile&& other);
+   MappedFile& operator=(MappedFile&& other);
+
+   MappedFile(const MappedFile&) = delete;
+   MappedFile& operator=(const MappedFile&) = delete;
+
+   ~MappedFile();
+
+   /**
+    * Returns a pointer to the first byte of the file.
+    */
+   const char* data() const
+   { return static_cast<const char*>(m_data); }
+
+   /**
+    * Returns the size of the file in bytes.
+    */
+   size_t size() const
+   { return m_size; }
+
+   /**
+    * Announces how the bytes in \f$[offset, offset + length)\f$ are about to
+    * be accessed.  This is only a hint: errors are ignored.
+    */
+   void advise(Access access, size_t offset = 0, size_t length = size_t(-1)) const;
+
+private:
+   void* m_data;
+   size_t m_size;
+
+   void release();
+};
+
+/**
+ * Read-write memory mapping of a temporary file, used as memory that can be
+ * paged out to disk.
+ *
+ * The file is created in a given directory and removed immediately, so that
+ * it disappears with the mapping, even if the process is killed.  Its space
+ * is reserved when it is created, so that running out of disk space is
+ * reported by the constructor instead of a bus error on first write.  The
+ * mapping is shared with the page cache, so the kernel can write dirty
+ * pages back to the file and reclaim them under memory pressure, which lets
+ * the mapped data exceed the physical memory.
+ */
+class MappedTempFile {
+public:
+   /**
+    * Creates and maps a zero-filled file of \c size bytes in \c directory.
+    *
+    * Throws \c std::runtime_error if the file cannot be created, extended
+    * or mapped.
+    */
+   MappedTempFile(const std::string& directory, size_t size);
+
+   MappedTempFile(MappedTempFile&& other);
+   MappedTempFile& operator=(MappedTempFile&& other);
+
+   MappedTempFile(const MappedTempFile&) = delete;
+   MappedTempFile& operator=(const MappedTempFile&) = delete;
+
+   ~MappedTempFile();
+
+   /**
+    * Returns a pointer to the first byte of the file.
+    */
+   char* data() const
+   { return static_cast<char*>(m_data); }
+
+   /**
+    * Returns the size of the file in bytes.
+    */
+   size_t size() const
+   { return m_size; }
+
+   /**
+    * Same as MappedFile::advise().
+    */
+   void advise(MappedFile::Access access, size_t offset = 0, size_t length = size_t(-1)) const;
+
+private:
+   void* m_data;
+   size_t m_size;
+
+   void release();
+};
+
+}
+
+#endif
@@ -0,0 +1,98 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__MERIT_SEQ__CBC_STATE_H
+#define POLLATBUILDER__MERIT_SEQ__CBC_STATE_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/LatDef.h"
+#include "PolLatbuilder/SizeParam-ORDINARY.h"
+#include "PolLatbuilder/MeritSeq/CoordUniformState.h"
+
+#include <memory>
+#include <string>
+
+namespace PolLatBuilder { namespace MeritSeq {
+
+/**
+ * Persistent state of a component-by-component construction.
+ *
+ * Holds everything CoordUniformCBC needs to append more coordinates to a
+ * lattice built earlier: the base lattice, its merit, the per-point state
+ * vectors with their weights, and the kernel values and accumulator used,
+ * which are checked against those of the evaluator that resumes the
+ * construction.
+ *
+ * The file format is binary, in the native byte order; a byte-order mark is
+ * checked on loading.
+ */
+struct CBCState {
+   /// Base lattice.
+   LatDef<LatType::ORDINARY> baseLat;
+   /// Merit of the base lattice.
+   Real baseMerit;
+   /// Precision of the state at dimension 0 (see CoordUniformCBC::reset()).
+   Precision precision;
+   /// Error bound on the merit due to single-precision storage (see
+   /// CoordUniformCBC::precisionError()).
+   Real precisionError;
+   /// Embedded modulus that determines the order of the points (see
+   /// CoordUniformCBC::setEmbeddedModulus()), or 0.
+   Poly embeddedModulus;
+   /// Name of the accumulator (see Functor::Sum).
+   std::string accumulator;
+   /// Kernel values for \f$\nu = 0, \dots, m\f$ (see Kernel::NuTable::valueAt()).
+   RealVector kernelValues;
+   /// State of the figure of merit for the base lattice.
+   std::unique_ptr<CoordUniformState> state;
+
+   /**
+    * Writes the state to the file at \c path.
+    */
+   void save(const std::string& path) const
+   { save(path, baseLat, baseMerit, precision, precisionError, embeddedModulus, accumulator, kernelValues, *state); }
+
+   /**
+    * Writes the given state to the file at \c path without copying it
+    * into a CBCState first.
+    */
+   static void save(
+         const std::string& path,
+         const LatDef<LatType::ORDINARY>& baseLat,
+         Real baseMerit,
+         Precision precision,
+         Real precisionError,
+         const Poly& embeddedModulus,
+         const std::string& accumulator,
+         const RealVector& kernelValues,
+         const CoordUniformState& state);
+
+   /**
+    * Reads a state written by save().
+    *
+    * The file is memory-mapped and its pages are read sequentially as the
+    * state vectors are restored.  The current PolyModP modulus must be that
+    * of the saved lattice.  The state vectors are stored in \c storage, so
+    * that a state larger than the memory can be restored into mapped files,
+    * in double precision if the saved state had been converted to it.
+    * Throws \c std::runtime_error if the file is invalid.
+    */
+   static CBCState load(const std::string& path, const StateStorage& storage = StateStorage());
+};
+
+}}
+
+#endif
@@ -0,0 +1,1074 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__MERIT_SEQ__COORD_UNIFORM_CBC_H
+#define POLLATBUILDER__MERIT_SEQ__COORD_UNIFORM_CBC_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/LatDef.h"
+#include "PolLatbuilder/ModularPoly.h"
+#include "PolLatbuilder/Util.h"
+#include "PolLatbuilder/MeritSeq/CoordUniformState.h"
+#include "PolLatbuilder/MeritSeq/CBCState.h"
+#include "PolLatbuilder/Kernel/NuTable.h"
+#include "PolLatbuilder/Functor/Accumulator.h"
+#include "PolLatbuilder/Parallel/SharedBound.h"
+#include "PolLatbuilder/Parallel/Pipeline.h"
+#include "PolLatbuilder/GenSeq/Extend.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace PolLatBuilder { namespace MeritSeq {
+
+/**
+ * Component-by-component evaluation of a coordinate-uniform figure of merit
+ * for polynomial lattice rules.
+ *
+ * Keeps a base lattice and the state of the figure of merit for that lattice,
+ * and evaluates the merit of the lattices obtained by appending one more
+ * component to its generating vector.  Each evaluation costs \f$O(n)\f$
+ * operations for \f$n\f$ points, independently of the dimension and of the
+ * weights; selecting a component updates the state.
+ *
+ * The digits of the new coordinate of all points are generated in Gray-code
+ * order from the Laurent expansion of \f$g/P\f$ (see PointSet), with one XOR
+ * per point, in blocks of blockSize() points.  The kernel values of each
+ * block are then read from a precomputed Kernel::NuTable in a separate loop
+ * without dependencies between points, so that no transcendental function is
+ * evaluated per point.
+ *
+ * Sequences of candidates are evaluated in tiles of candidateBlockSize()
+ * candidates by blockSize() points (see merits()): each block of the state
+ * vector is loaded once in the L1 cache and reused for all candidates of the
+ * tile, instead of streaming the whole state vector from memory once per
+ * candidate.  Alternatively, for moduli of degree at most 32, up to 64
+ * candidates can be evaluated together in bit-sliced form (see Backend).
+ *
+ * Evaluations can be abandoned early against a best-so-far bound (see
+ * merits() and selectBest()): the weighted sum of the kernel values is
+ * accumulated block by block, and after each block it is compared with a
+ * lower bound on the sum over the remaining points, obtained from the
+ * extreme kernel values and the sums of the positive and of the negative
+ * parts of the state over the remaining blocks.  The comparison includes a
+ * margin for rounding errors, so that a candidate is abandoned only if its
+ * fully evaluated merit would be larger than the bound, and the results are
+ * identical to those of full evaluations.
+ *
+ * A rule with modulus \f$P'\f$ can be grown from a rule with a modulus
+ * \f$P\f$ that divides \f$P'\f$, such as \f$x^m\f$ to \f$x^{m+1}\f$, with
+ * extend(): each component is chosen among the generators that reduce to
+ * the corresponding component of the smaller rule modulo \f$P\f$ (see
+ * GenSeq::Extend).  The points are then ordered so that the points
+ * \f$k = Q k_0\f$, with \f$Q = P'/P\f$ and \f$\deg k_0 < \deg P\f$, come
+ * first (see setEmbeddedModulus()); their digits \f$k_0 g / P\f$ are the same
+ * for all these candidates, so their weighted sum is computed once per
+ * coordinate and only the other points are visited for each candidate.
+ *
+ * The state vectors can be stored in single precision (see Precision) to
+ * halve their size and the memory traffic of each evaluation.  Each block of
+ * the weighted state is then converted to double precision once for all the
+ * candidates evaluated on it, and the sums over the blocks are always
+ * accumulated in double precision with compensated summation.  The bound on
+ * the error of the weighted state (see StateVector::error()) is accumulated
+ * over the selected coordinates, and the state is converted to double
+ * precision as soon as the bound on the error of the merit after the next
+ * coordinate would exceed precisionTolerance() times the merit.
+ *
+ * For large moduli, the state vectors and the kernel values of the selected
+ * coordinates can be stored in temporary files mapped in memory (see
+ * StateStorage::mapped()) instead of failing to allocate them.  The
+ * evaluations and the updates visit the points in increasing order, block
+ * by block, and read the next chunk of each vector ahead while the current
+ * one is processed, so that they run close to the disk bandwidth once the
+ * state exceeds the physical memory.
+ *
+ * The construction can be saved with save() and resumed later, possibly in
+ * another process, by constructing an evaluator from the loaded CBCState:
+ * appending \f$k\f$ more coordinates then costs only \f$k\f$ CBC steps.
+ *
+ * \tparam KERNEL    Kernel type; must provide
+ *                   <tt>std::shared_ptr<const Kernel::NuTable> table(unsigned
+ *                   numDigits) const</tt>, such as Kernel::PAlphaPLR.
+ * \tparam ACC       Accumulator that combines the merit of the base lattice
+ *                   with the contribution of the new coordinate, such as
+ *                   Functor::Sum (the default) or Functor::Max.
+ */
+template <class KERNEL, class ACC = Functor::Sum>
+class CoordUniformCBC {
+public:
+   typedef PolLatBuilder::Kernel::NuTable Table;
+   typedef KERNEL Kernel;
+   typedef ACC Accumulator;
+
+   /**
+    * Evaluation methods for sequences of candidates.
+    *
+    * - \c TILED: each candidate has its own digits, evaluated in tiles with
+    *   the vectorized kernel of Table::dot().
+    * - \c BIT_SLICED: the digits of up to 64 candidates are stored
+    *   transposed, one word per digit with one bit per candidate, so that
+    *   moving all of them to the next point costs one XOR per digit, and the
+    *   positions \f$\nu\f$ of their first nonzero digits are found with
+    *   word-wide AND and OR operations, one digit at a time, until all
+    *   candidates are resolved.  Available for moduli of degree at most 32.
+    * - \c AUTO: \c BIT_SLICED when it is available with vector
+    *   instructions (see Table::bitSlicedVectorized()) and at least 48
+    *   candidates are evaluated together, \c TILED otherwise.
+    */
+   enum class Backend { AUTO, TILED, BIT_SLICED };
+
+   /**
+    * Returns the number of points whose digits are generated before their
+    * kernel values are looked up.
+    */
+   static constexpr Modulus blockSize()
+   { return 1024; }
+
+   /**
+    * Returns the number of candidates evaluated together by merits().
+    */
+   static constexpr size_t candidateBlockSize()
+   { return 8; }
+
+   /**
+    * Returns the maximum number of candidates evaluated together by the
+    * bit-sliced backend.
+    */
+   static constexpr size_t bitSliceWidth()
+   { return 64; }
+
+   /**
+    * Returns the maximum degree of the modulus for the bit-sliced backend.
+    */
+   static constexpr unsigned maxBitSlicedDegree()
+   { return Table::maxBitSlicedDigits(); }
+
+   /**
+    * Constructor.
+    *
+    * \param sizeParam  Size parameter of the lattices; the degree of the
+    *                   modulus must be at most 63.
+    * \param kernel     Kernel.
+    * \param state      State of the figure of merit, created for instance
+    *                   with CoordUniformStateCreator.
+    */
+   CoordUniformCBC(
+         SizeParam<LatType::ORDINARY> sizeParam,
+         Kernel kernel,
+         std::unique_ptr<CoordUniformState> state):
+      m_baseLat(std::move(sizeParam)),
+      m_kernel(std::move(kernel)),
+      m_state(std::move(state)),
+      m_degree(deg(m_baseLat.sizeParam().polynomial())),
+      m_modulus(polyToInt(m_baseLat.sizeParam().polynomial())),
+      m_baseMerit(0.0),
+      m_backend(Backend::AUTO),
+      m_earlyAbandon(true),
+      m_embedded(0),
+      m_embeddedDegree(0),
+      m_precision(m_state->precision()),
+      m_precisionTolerance(1e-4),
+      m_precisionError(0.0)
+   {
+      if (m_degree < 1 or m_degree > 63)
+         throw std::runtime_error("CoordUniformCBC: modulus degree must be in 1..63");
+      if (m_state->numPoints() != numPoints())
+         throw std::runtime_error("CoordUniformCBC: state has the wrong number of points");
+      m_table = m_kernel.table(m_degree);
+      updateBounds();
+   }
+
+   /**
+    * Constructor that resumes a construction saved with save().
+    *
+    * The precision restored by reset() and the error bound on the merit
+    * (see precisionError()) are those of the saved evaluator, and the state
+    * is converted to double precision if its restored error bound requires
+    * it.
+    *
+    * Throws \c std::runtime_error if \c saved was obtained with a different
+    * kernel or accumulator.
+    */
+   CoordUniformCBC(Kernel kernel, CBCState saved):
+      CoordUniformCBC(saved.baseLat.sizeParam(), std::move(kernel), std::move(saved.state))
+   {
+      if (saved.accumulator != Accumulator::name())
+         throw std::runtime_error("CoordUniformCBC: saved state uses another accumulator");
+      if (not IsZero(saved.embeddedModulus))
+         setEmbeddedModulus(saved.embeddedModulus);
+      if (saved.kernelValues.size() != m_degree + 1)
+         throw std::runtime_error("CoordUniformCBC: saved state uses another kernel");
+      for (unsigned nu = 0; nu <= m_degree; nu++) {
+         if (saved.kernelValues[nu] != m_table->valueAt(nu))
+            throw std::runtime_error("CoordUniformCBC: saved state uses another kernel");
+      }
+      m_baseLat = std::move(saved.baseLat);
+      m_baseMerit = saved.baseMerit;
+      m_precision = saved.precision;
+      m_precisionError = saved.precisionError;
+      checkPrecision();
+      updateBounds();
+   }
+
+   CoordUniformCBC(const CoordUniformCBC& other):
+      m_baseLat(other.m_baseLat),
+      m_kernel(other.m_kernel),
+      m_state(other.m_state->clone()),
+      m_table(other.m_table),
+      m_degree(other.m_degree),
+      m_modulus(other.m_modulus),
+      m_baseMerit(other.m_baseMerit),
+      m_backend(other.m_backend),
+      m_earlyAbandon(other.m_earlyAbandon),
+      m_embedded(other.m_embedded),
+      m_embeddedDegree(other.m_embeddedDegree),
+      m_precision(other.m_precision),
+      m_precisionTolerance(other.m_precisionTolerance),
+      m_precisionError(other.m_precisionError),
+      m_remainderBounds(other.m_remainderBounds),
+      m_roundingMargin(other.m_roundingMargin)
+   {}
+
+   /**
+    * Returns the base lattice.
+    */
+   const LatDef<LatType::ORDINARY>& baseLat() const
+   { return m_baseLat; }
+
+   /**
+    * Returns the figure of merit of the base lattice.
+    */
+   Real baseMerit() const
+   { return m_baseMerit; }
+
+   /**
+    * Returns the kernel.
+    */
+   const Kernel& kernel() const
+   { return m_kernel; }
+
+   /**
+    * Returns the evaluation method used by merits().
+    */
+   Backend backend() const
+   { return m_backend; }
+
+   /**
+    * Sets the evaluation method used by merits().
+    *
+    * Throws if \c BIT_SLICED is requested and the degree of the modulus is
+    * larger than maxBitSlicedDegree().
+    */
+   void setBackend(Backend backend)
+   {
+      if (backend == Backend::BIT_SLICED and m_degree > maxBitSlicedDegree())
+         throw std::runtime_error("CoordUniformCBC: bit-sliced evaluation requires a modulus degree at most 32");
+      m_backend = backend;
+   }
+
+   /**
+    * Returns \c true if selectBest() abandons candidates early.
+    */
+   bool earlyAbandon() const
+   { return m_earlyAbandon; }
+
+   /**
+    * Enables or disables early abandoning of candidates in selectBest().
+    *
+    * This does not change the results, only the time needed to obtain them.
+    */
+   void setEarlyAbandon(bool enabled)
+   { m_earlyAbandon = enabled; }
+
+   /**
+    * Returns the largest relative error on the merit of the base lattice
+    * allowed before single-precision state vectors are converted to double
+    * precision.
+    */
+   Real precisionTolerance() const
+   { return m_precisionTolerance; }
+
+   /**
+    * Sets the value returned by precisionTolerance(); the default is
+    * \f$10^{-4}\f$.
+    */
+   void setPrecisionTolerance(Real tolerance)
+   { m_precisionTolerance = tolerance; }
+
+   /**
+    * Returns a bound on the absolute error on the merit of the base lattice
+    * due to the storage of the state vectors in single precision.
+    */
+   Real precisionError() const
+   { return m_precisionError; }
+
+   /**
+    * Returns the modulus of the embedded rule set with
+    * setEmbeddedModulus(), or 0 if there is none.
+    */
+   Poly embeddedModulus() const
+   { return m_embedded ? intToPoly(m_embedded) : Poly(0); }
+
+   /**
+    * Orders the points for the extension of a rule with modulus \c base, a
+    * divisor of the modulus \f$P'\f$ of this evaluator.
+    *
+    * With \f$Q = P'/\mathtt{base}\f$, the Gray-code index of the points runs
+    * first through the multiples \f$k = Q k_0\f$ of \f$Q\f$, in the
+    * Gray-code order of the rule with modulus \c base, and then through the
+    * other residues modulo \f$Q\f$.  The point set is unchanged, but the
+    * state vectors and kernelValues() follow this order, and merits() computes
+    * the sum over the first \f$2^{\deg \mathtt{base}}\f$ points once for all
+    * candidates that are congruent modulo \c base.
+    *
+    * The base lattice must be empty.  A \c base of degree 0 restores the
+    * default order.
+    */
+   void setEmbeddedModulus(const Poly& base)
+   {
+      if (m_baseLat.dimension() > 0)
+         throw std::runtime_error("CoordUniformCBC: the point order can only change at dimension 0");
+      if (IsZero(base) or not IsZero(m_baseLat.sizeParam().polynomial() % base))
+         throw std::runtime_error("CoordUniformCBC: the embedded modulus must divide the modulus");
+      m_embeddedDegree = deg(base);
+      m_embedded = m_embeddedDegree > 0 ? polyToInt(base) : 0;
+      if (not m_embedded)
+         m_embeddedDegree = 0;
+   }
+
+   /**
+    * Returns the table of kernel values.
+    */
+   const Table& table() const
+   { return *m_table; }
+
+   /**
+    * Returns the state of the figure of merit.
+    */
+   const CoordUniformState& state() const
+   { return *m_state; }
+
+   /**
+    * Returns the number of points.
+    */
+   Modulus numPoints() const
+   { return Modulus(1) << m_degree; }
+
+   /**
+    * Returns the merit of the lattice obtained by appending \c gen to the
+    * generating vector of the base lattice.
+    */
+   Real operator()(const PolyModP& gen) const
+   { return Accumulator()(m_baseMerit, contribution(gen)); }
+
+   /// \copydoc operator()(const PolyModP&) const
+   Real operator()(const ModularPoly& gen) const
+   { return Accumulator()(m_baseMerit, contribution(gen)); }
+
+   /**
+    * Returns the merit of \c lat, which must be obtained by appending one
+    * component to the generating vector of the base lattice, as with
+    * LatSeq::CBC.
+    */
+   Real operator()(const LatDef<LatType::ORDINARY>& lat) const
+   {
+#ifndef NDEBUG
+      if (lat.dimension() != m_baseLat.dimension() + 1)
+         throw std::runtime_error("CoordUniformCBC: lattice does not extend the base lattice");
+#endif
+      return operator()(lat.gen().back());
+   }
+
+   /**
+    * Returns the contribution of the coordinate generated by \c gen to the
+    * merit, which is combined with the merit of the base lattice by the
+    * accumulator.
+    */
+   Real contribution(const PolyModP& gen) const
+   { return contributionOf(residue(gen)); }
+
+   /// \copydoc contribution(const PolyModP&) const
+   Real contribution(const ModularPoly& gen) const
+   { return contributionOf(residue(gen)); }
+
+   /**
+    * Returns the kernel values of the coordinate generated by \c gen, for all
+    * points in Gray-code order.
+    */
+   RealVector kernelValues(const PolyModP& gen) const
+   { return kernelValuesOf(residue(gen)).toReal(); }
+
+   /// \copydoc kernelValues(const PolyModP&) const
+   RealVector kernelValues(const ModularPoly& gen) const
+   { return kernelValuesOf(residue(gen)).toReal(); }
+
+   /**
+    * Appends \c gen to the generating vector of the base lattice and updates
+    * the state.
+    */
+   void select(const PolyModP& gen)
+   { selectResidue(residue(gen), gen); }
+
+   /**
+    * \copydoc select(const PolyModP&)
+    *
+    * The modulus of \c gen must be that of the base lattice; the PolyModP
+    * context is not used.
+    */
+   void select(const ModularPoly& gen)
+   { selectResidue(residue(gen), gen.toPolyModP()); }
+
+   /**
+    * Writes to \c out the merits of the lattices obtained by appending each
+    * of the generator values in \f$[first, last)\f$ to the generating vector
+    * of the base lattice.
+    *
+    * The candidates are read in groups of bitSliceWidth() and each group is
+    * evaluated with the method selected by setBackend().
+    *
+    * \param bound     If not null, the evaluation of each candidate is
+    *                  abandoned, and infinity is written instead of its merit,
+    *                  as soon as its merit is known to be larger than the
+    *                  current value of \c bound.  The bound can be lowered
+    *                  concurrently by other threads.
+    */
+   template <class ITERATOR>
+   void merits(ITERATOR first, ITERATOR last, Real* out, const Parallel::SharedBound* bound = nullptr) const
+   {
+      std::vector<std::vector<uint64_t>> cols;
+      CompensatedSum sums[bitSliceWidth()];
+      while (first != last) {
+         cols.clear();
+         for (; first != last and cols.size() < bitSliceWidth(); ++first)
+            cols.push_back(columns(residue(*first)));
+         embeddedSums(cols, sums);
+         if (useBitSliced(cols.size()))
+            sumsBitSliced(cols, sums, bound);
+         else
+            sumsTiled(cols, sums, bound);
+         for (size_t c = 0; c < cols.size(); c++)
+            *out++ = Accumulator()(m_baseMerit, sums[c].value() / Real(numPoints()));
+      }
+   }
+
+   /**
+    * Evaluates all generator values in \c genSeq, selects the one with the
+    * smallest merit and returns that merit.
+    *
+    * The candidates are evaluated with merits(), abandoning those that
+    * cannot beat the best merit found so far if earlyAbandon() is \c true.
+    * Ties are resolved in favor of the first value in \c genSeq.
+    */
+   template <class GENSEQ>
+   Real selectBest(const GENSEQ& genSeq)
+   {
+      Real best = std::numeric_limits<Real>::infinity();
+      typename GENSEQ::value_type bestGen{};
+      bool found = false;
+      Parallel::SharedBound bound;
+
+      std::vector<typename GENSEQ::value_type> group;
+      group.reserve(bitSliceWidth());
+      Real values[bitSliceWidth()];
+      auto flush = [&]() {
+         merits(group.begin(), group.end(), values, m_earlyAbandon ? &bound : nullptr);
+         for (size_t c = 0; c < group.size(); c++) {
+            if (values[c] < best) {
+               best = values[c];
+               bestGen = group[c];
+               found = true;
+            }
+         }
+         bound.improve(best);
+         group.clear();
+      };
+
+      for (const auto& gen : genSeq) {
+         group.push_back(gen);
+         if (group.size() == bitSliceWidth())
+            flush();
+      }
+      flush();
+
+      if (not found)
+         throw std::runtime_error("CoordUniformCBC: empty generator sequence");
+      select(bestGen);
+      return best;
+   }
+
+   /**
+    * Same as selectBest(const GENSEQ&), but generates the candidates and
+    * evaluates them concurrently with \c pipeline.
+    *
+    * \c genSeq must provide \c size() and <tt>operator[]</tt>, and is
+    * accessed concurrently by the producer threads of \c pipeline.  The
+    * evaluator threads call merits() on each batch, with the bound of the
+    * pipeline if earlyAbandon() is \c true.  The batch size of \c pipeline
+    * must be a multiple of bitSliceWidth(), so that the candidates are
+    * evaluated in the same groups, hence with the same rounding errors, as
+    * by selectBest(const GENSEQ&): the selected value is the same and does
+    * not depend on the number of threads.
+    */
+   template <class GENSEQ>
+   Real selectBest(const GENSEQ& genSeq, Parallel::Pipeline<typename GENSEQ::value_type>& pipeline)
+   {
+      typedef typename GENSEQ::value_type value_type;
+      if (pipeline.batchSize() % bitSliceWidth() != 0)
+         throw std::runtime_error("CoordUniformCBC: pipeline batch size must be a multiple of bitSliceWidth()");
+      const auto winner = pipeline.run(
+            genSeq.size(),
+            [&genSeq](size_t i) { return value_type(genSeq[i]); },
+            [this](const value_type* values, size_t count, Real* out, const Parallel::SharedBound& bound)
+            { merits(values, values + count, out, m_earlyAbandon ? &bound : nullptr); });
+      if (not winner.found())
+         throw std::runtime_error("CoordUniformCBC: empty generator sequence");
+      select(winner.value);
+      return winner.merit;
+   }
+
+   /**
+    * Writes the base lattice, its merit and the state of the figure of merit
+    * to the file at \c path, to be resumed with CBCState::load().
+    */
+   void save(const std::string& path) const
+   {
+      RealVector kernelValues;
+      for (unsigned nu = 0; nu <= m_degree; nu++)
+         kernelValues.push_back(m_table->valueAt(nu));
+      CBCState::save(path, m_baseLat, m_baseMerit, m_precision, m_precisionError,
+            embeddedModulus(), Accumulator::name(), kernelValues, *m_state);
+   }
+
+   /**
+    * Replaces the base lattice with an extension of \c lat, whose modulus
+    * must divide the modulus of this evaluator, and returns its merit.
+    *
+    * The points are ordered with setEmbeddedModulus(), and each component
+    * is selected with selectBest() among the generators that reduce to the
+    * corresponding component of \c lat (see GenSeq::Extend).
+    */
+   Real extend(const LatDef<LatType::ORDINARY>& lat)
+   {
+      const Poly& base = lat.sizeParam().polynomial();
+      reset();
+      setEmbeddedModulus(base);
+      for (const auto& gen : lat.gen())
+         selectBest(GenSeq::Extend<>(m_baseLat.sizeParam().polynomial(), base, rep(gen)));
+      return m_baseMerit;
+   }
+
+   /**
+    * Resets the base lattice to dimension 0.
+    */
+   void reset()
+   {
+      m_baseLat.gen().clear();
+      m_state->setPrecision(m_precision);
+      m_state->reset();
+      m_baseMerit = 0.0;
+      m_precisionError = 0.0;
+      updateBounds();
+   }
+
+   /**
+    * Returns \c true if the merit of the base lattice is known to be larger
+    * than \c bound, taking rounding errors into account.
+    *
+    * If the contributions of the coordinates are nonnegative (see
+    * evaluate(const LatDef<LatType::ORDINARY>&, const Parallel::SharedBound&)),
+    * this also holds for all lattices that extend the base lattice.
+    */
+   bool exceeds(Real bound) const
+   { return sumThreshold(bound) < 0.0; }
+
+   /**
+    * Returns the merit of \c lat, by selecting its components one after the
+    * other from an empty base lattice.
+    *
+    * The base lattice is replaced with \c lat.
+    */
+   Real evaluate(const LatDef<LatType::ORDINARY>& lat)
+   {
+      reset();
+      for (const auto& gen : lat.gen())
+         select(gen);
+      return m_baseMerit;
+   }
+
+   /**
+    * Same as evaluate(), but returns infinity as soon as the merit of \c lat
+    * is known to be larger than the current value of \c bound, for
+    * exhaustive searches.
+    *
+    * The contributions of the coordinates must be nonnegative, as for kernels
+    * with nonnegative Walsh coefficients and nonnegative weights.  If the
+    * evaluation is abandoned, the base lattice contains the components
+    * selected so far.
+    */
+   Real evaluate(const LatDef<LatType::ORDINARY>& lat, const Parallel::SharedBound& bound)
+   {
+      reset();
+      const auto& gen = lat.gen();
+      for (Dimension j = 0; j < gen.size(); j++) {
+         if (j + 1 == gen.size()) {
+            Real merit;
+            merits(&gen[j], &gen[j] + 1, &merit, &bound);
+            if (std::isinf(merit))
+               return merit;
+         }
+         select(gen[j]);
+         if (exceeds(bound.get()))
+            return std::numeric_limits<Real>::infinity();
+      }
+      return m_baseMerit;
+   }
+
+private:
+   LatDef<LatType::ORDINARY> m_baseLat;
+   Kernel m_kernel;
+   std::unique_ptr<CoordUniformState> m_state;
+   std::shared_ptr<const Table> m_table;
+   unsigned m_degree;
+   Modulus m_modulus;
+   Real m_baseMerit;
+   Backend m_backend;
+   bool m_earlyAbandon;
+   /// Modulus of the embedded rule (see setEmbeddedModulus()), or 0.
+   Modulus m_embedded;
+   unsigned m_embeddedDegree;
+   /// Precision of the state at dimension 0.
+   Precision m_precision;
+   Real m_precisionTolerance;
+   Real m_precisionError;
+
+   /// Lower bounds on the weighted sums of the kernel values over the points
+   /// from each block boundary to the last point.
+   RealVector m_remainderBounds;
+   /// Bound on the rounding errors on weighted sums of kernel values.
+   Real m_roundingMargin;
+
+   /**
+    * Updates the bounds used to abandon evaluations early, after a change of
+    * the state.
+    */
+   void updateBounds()
+   {
+      Real lowest = std::numeric_limits<Real>::infinity();
+      Real highest = -lowest;
+      for (unsigned nu = 0; nu <= m_degree; nu++) {
+         lowest = std::min(lowest, m_table->valueAt(nu));
+         highest = std::max(highest, m_table->valueAt(nu));
+      }
+
+      const StateVector& q = m_state->weightedState();
+      const Modulus n = numPoints();
+      const Modulus numBlocks = (n + blockSize() - 1) / blockSize();
+      m_remainderBounds.assign(numBlocks + 1, 0.0);
+      Real positive = 0.0;
+      Real negative = 0.0;
+      for (Modulus k = numBlocks; k-- > 0; ) {
+         Real blockPositive = 0.0;
+         Real blockNegative = 0.0;
+         for (Modulus i = k * blockSize(); i < std::min(n, (k + 1) * blockSize()); i++) {
+            if (q[i] > 0.0)
+               blockPositive += q[i];
+            else
+               blockNegative += q[i];
+         }
+         positive += blockPositive;
+         negative += blockNegative;
+         m_remainderBounds[k] = positive * lowest + negative * highest;
+      }
+
+      // blocked sums of n terms have errors below (block size + number of
+      // blocks) units in the last place of the sum of their magnitudes
+      const Real eps = std::numeric_limits<Real>::epsilon();
+      const Real magnitude = (positive - negative) * std::max(std::abs(lowest), std::abs(highest));
+      m_roundingMargin = 2.0 * Real(blockSize() + numBlocks + 4) * eps * magnitude;
+   }
+
+   /**
+    * Returns the largest weighted sum of kernel values of a candidate, over
+    * all points, for which its merit might not exceed \c bound, including
+    * the margin for rounding errors.
+    */
+   Real sumThreshold(Real bound) const
+   {
+      if (std::isinf(bound))
+         return bound;
+      const Real n = Real(numPoints());
+      const Real eps = std::numeric_limits<Real>::epsilon();
+      return Accumulator::maxOperand(m_baseMerit, bound) * n
+         + m_roundingMargin + 4.0 * eps * n * (std::abs(bound) + std::abs(m_baseMerit));
+   }
+
+   /**
+    * Returns \c true if a candidate whose weighted sum over the points before
+    * block \c nextBlock is \c partial has a merit larger than the bound
+    * corresponding to \c threshold (see sumThreshold()).
+    */
+   bool cannotWin(const CompensatedSum& partial, Modulus nextBlock, Real threshold) const
+   { return partial.value() + m_remainderBounds[nextBlock] > threshold; }
+
+   /**
+    * Returns the mean of the absolute kernel values of a coordinate whose
+    * points take each of the \f$n\f$ possible values once, as for
+    * generators coprime with the modulus.
+    */
+   Real meanAbsKernel() const
+   {
+      // 2^{m - nu} points have their first nonzero digit at position nu
+      Real sum = std::abs(m_table->valueAt(0));
+      for (unsigned nu = 1; nu <= m_degree; nu++)
+         sum += std::ldexp(std::abs(m_table->valueAt(nu)), int(m_degree - nu));
+      return sum / Real(numPoints());
+   }
+
+   /**
+    * Converts the state to double precision if the error bound on the merit
+    * after the next coordinate would exceed the tolerance.
+    *
+    * The error on the contribution of a coordinate is at most the error
+    * bound on the weighted state times the mean absolute kernel value.
+    */
+   void checkPrecision()
+   {
+      if (m_state->precision() == Precision::DOUBLE)
+         return;
+      const Real next = m_state->weightedState().error() * meanAbsKernel();
+      if (m_precisionError + next > m_precisionTolerance * std::abs(m_baseMerit))
+         m_state->setPrecision(Precision::DOUBLE);
+   }
+
+   /**
+    * Returns the representative of \c gen.
+    */
+   static const Poly& residue(const PolyModP& gen)
+   { return rep(gen); }
+
+   /**
+    * Returns the representative of \c gen, after checking that its modulus is
+    * that of the base lattice.
+    */
+   const Poly& residue(const ModularPoly& gen) const
+   {
+      if (not gen.modulus() or polyToInt(gen.modulus()->polynomial()) != m_modulus)
+         throw std::runtime_error("CoordUniformCBC: generator value has a different modulus");
+      return rep(gen);
+   }
+
+   /// Implementation of contribution().
+   Real contributionOf(const Poly& gen) const
+   {
+      const StateVector& q = m_state->weightedState();
+      Real buffer[blockSize()];
+      CompensatedSum sum;
+      forEachBlock(gen, [&](Modulus first, const uint64_t* digits, Modulus count) {
+            sum += m_table->dot(digits, q.block(first, count, buffer), count);
+            });
+      return sum.value() / Real(numPoints());
+   }
+
+   /// Implementation of kernelValues(), in double precision in the
+   /// storage of the state.
+   StateVector kernelValuesOf(const Poly& gen) const
+   {
+      StateStorage storage = m_state->storage();
+      storage.precision = Precision::DOUBLE;
+      StateVector values(numPoints(), 0.0, storage);
+      forEachBlock(gen, [&](Modulus first, const uint64_t* digits, Modulus count) {
+            values.prefetch(first, count);
+            m_table->evaluate(digits, count, values.data() + first);
+            });
+      return values;
+   }
+
+   /// Implementation of select(); \c value is stored in the base lattice.
+   void selectResidue(const Poly& gen, const PolyModP& value)
+   {
+      // same blocks and summation order as in contribution() and merits()
+      m_baseMerit = Accumulator()(m_baseMerit, contributionOf(gen));
+      const StateVector values = kernelValuesOf(gen);
+      const Real error = m_state->weightedState().error();
+      if (error > 0.0) {
+         Real sum = 0.0;
+         for (Modulus i = 0; i < values.size(); i++)
+            sum += std::abs(values[i]);
+         m_precisionError += error * sum / Real(numPoints());
+      }
+      m_state->update(values);
+      m_baseLat.gen().push_back(value);
+      checkPrecision();
+      updateBounds();
+   }
+
+   /**
+    * Returns the digit columns of the coordinate generated by \c gen, for
+    * the point order selected with setEmbeddedModulus().
+    */
+   std::vector<uint64_t> columns(const Poly& gen) const
+   {
+      if (not m_embedded)
+         return laurentColumns(polyToInt(gen), m_modulus, m_degree, m_degree);
+      // the points Q x^b, for b < deg P, have the digits of x^b g / P, and
+      // the remaining basis points x^c those of x^c g / P'
+      const Poly reduced = gen % intToPoly(m_embedded);
+      auto cols = laurentColumns(polyToInt(reduced), m_embedded, m_degree, m_embeddedDegree);
+      const auto rest = laurentColumns(polyToInt(gen), m_modulus, m_degree, m_degree - m_embeddedDegree);
+      cols.insert(cols.end(), rest.begin(), rest.end());
+      return cols;
+   }
+
+   /**
+    * Returns the Gray-code index of the first point visited separately for
+    * each candidate by merits().
+    */
+   Modulus firstPoint() const
+   { return m_embedded ? Modulus(1) << m_embeddedDegree : 0; }
+
+   /**
+    * Returns the packed digits of the point of Gray-code index \c i for the
+    * digit columns \c cols.
+    */
+   static uint64_t pointDigits(const std::vector<uint64_t>& cols, Modulus i)
+   {
+      uint64_t x = 0;
+      for (Modulus k = i ^ (i >> 1); k; k &= k - 1)
+         x ^= cols[trailingZeros(k)];
+      return x;
+   }
+
+   /**
+    * Sets the first \c cols.size() elements of \c sums to the weighted sums
+    * of the kernel values of the candidates with digit columns \c cols over
+    * the points before firstPoint(), computed once for each group of
+    * candidates congruent modulo the embedded modulus.
+    */
+   void embeddedSums(const std::vector<std::vector<uint64_t>>& cols, CompensatedSum* sums) const
+   {
+      const Modulus n = firstPoint();
+      const StateVector& q = m_state->weightedState();
+      uint64_t block[blockSize()];
+      Real buffer[blockSize()];
+      for (size_t c = 0; c < cols.size(); c++) {
+         sums[c] = 0.0;
+         if (n == 0)
+            continue;
+         // the first columns are those of the generator modulo P
+         size_t same = 0;
+         while (same < c and not std::equal(cols[c].begin(), cols[c].begin() + m_embeddedDegree, cols[same].begin()))
+            same++;
+         if (same < c) {
+            sums[c] = sums[same];
+            continue;
+         }
+         uint64_t x = 0;
+         for (Modulus first = 0; first < n; first += blockSize()) {
+            const Modulus count = std::min(blockSize(), n - first);
+            fillBlock(cols[c].data(), first, count, x, block);
+            sums[c] += m_table->dot(block, q.block(first, count, buffer), count);
+         }
+      }
+   }
+
+   /**
+    * Returns the number of points from \c begin to the next block boundary
+    * or to the last point.
+    */
+   Modulus blockCount(Modulus begin) const
+   { return std::min(blockSize() - begin % blockSize(), numPoints() - begin); }
+
+   bool useBitSliced(size_t numCandidates) const
+   {
+      switch (m_backend) {
+         case Backend::BIT_SLICED:
+            return true;
+         case Backend::TILED:
+            return false;
+         default:
+            return m_degree <= maxBitSlicedDegree() and m_table->bitSlicedVectorized()
+               and numCandidates >= 3 * bitSliceWidth() / 4;
+      }
+   }
+
+   /**
+    * Adds to \c sums the weighted sums of the kernel values of the
+    * candidates with digit columns \c cols, at most bitSliceWidth() of
+    * them, over the points from firstPoint(), evaluated in tiles of
+    * candidateBlockSize() candidates.
+    *
+    * If \c bound is not null, the sums of the candidates abandoned early are
+    * set to infinity.
+    */
+   void sumsTiled(const std::vector<std::vector<uint64_t>>& cols, CompensatedSum* sums, const Parallel::SharedBound* bound) const
+   {
+      const StateVector& q = m_state->weightedState();
+      const Modulus n = numPoints();
+      uint64_t state[candidateBlockSize()];
+      bool active[candidateBlockSize()];
+      uint64_t block[blockSize()];
+      Real buffer[blockSize()];
+
+      for (size_t tile = 0; tile < cols.size(); tile += candidateBlockSize()) {
+         const size_t numCandidates = std::min(candidateBlockSize(), cols.size() - tile);
+         for (size_t c = 0; c < numCandidates; c++)
+            state[c] = firstPoint() ? pointDigits(cols[tile + c], firstPoint() - 1) : 0;
+         std::fill(active, active + numCandidates, true);
+         size_t numActive = numCandidates;
+         Modulus count;
+         for (Modulus begin = firstPoint(); begin < n and numActive > 0; begin += count) {
+            count = blockCount(begin);
+            const Real threshold = bound ? sumThreshold(bound->get()) : std::numeric_limits<Real>::infinity();
+            const Real* weights = q.block(begin, count, buffer);
+            for (size_t c = 0; c < numCandidates; c++) {
+               if (not active[c])
+                  continue;
+               fillBlock(cols[tile + c].data(), begin, count, state[c], block);
+               sums[tile + c] += m_table->dot(block, weights, count);
+               if (cannotWin(sums[tile + c], (begin + count + blockSize() - 1) / blockSize(), threshold)) {
+                  sums[tile + c] = std::numeric_limits<Real>::infinity();
+                  active[c] = false;
+                  numActive--;
+               }
+            }
+         }
+      }
+   }
+
+   /**
+    * Bit-sliced counterpart of sumsTiled(); see Backend and
+    * Table::bitSlicedDot().
+    */
+   void sumsBitSliced(const std::vector<std::vector<uint64_t>>& cols, CompensatedSum* sums, const Parallel::SharedBound* bound) const
+   {
+      const unsigned m = m_degree;
+      const size_t numCandidates = cols.size();
+      uint64_t sets = numCandidates == 64 ? ~uint64_t(0) : (uint64_t(1) << numCandidates) - 1;
+
+      // transposed columns: bit c of slices[b * stride + r] is bit r of
+      // column b of candidate c
+      const unsigned stride = Table::maxBitSlicedDigits();
+      std::vector<uint64_t> slices(m * stride, 0);
+      for (size_t c = 0; c < numCandidates; c++)
+         for (unsigned b = 0; b < m; b++)
+            for (uint64_t w = cols[c][b]; w; w &= w - 1)
+               slices[b * stride + trailingZeros(w)] |= uint64_t(1) << c;
+
+      const StateVector& q = m_state->weightedState();
+      const Modulus n = numPoints();
+      Real buffer[blockSize()];
+      Real partial[bitSliceWidth()];
+      uint64_t state[maxBitSlicedDegree()] = {};
+      if (firstPoint()) {
+         for (size_t c = 0; c < numCandidates; c++)
+            for (uint64_t w = pointDigits(cols[c], firstPoint() - 1); w; w &= w - 1)
+               state[trailingZeros(w)] |= uint64_t(1) << c;
+      }
+      Modulus count;
+      for (Modulus begin = firstPoint(); begin < n and sets; begin += count) {
+         count = blockCount(begin);
+         // the sums over each block are added to the compensated sums
+         std::fill(partial, partial + numCandidates, 0.0);
+         m_table->bitSlicedDot(slices.data(), sets, state, begin, q.block(begin, count, buffer), count, partial);
+         for (uint64_t rest = sets; rest; rest &= rest - 1)
+            sums[trailingZeros(rest)] += partial[trailingZeros(rest)];
+         if (bound) {
+            // abandoned candidates are removed from the evaluated sets
+            const Real threshold = sumThreshold(bound->get());
+            for (uint64_t rest = sets; rest; rest &= rest - 1) {
+               const unsigned c = trailingZeros(rest);
+               if (cannotWin(sums[c], (begin + count + blockSize() - 1) / blockSize(), threshold)) {
+                  sums[c] = std::numeric_limits<Real>::infinity();
+                  sets &= ~(uint64_t(1) << c);
+               }
+            }
+         }
+      }
+   }
+
+   /**
+    * Writes to \c block the packed digits of the points of Gray-code indices
+    * \c first to <tt>first + count - 1</tt> for the digit columns \c cols.
+    *
+    * \param x     Digits of the point of index <tt>first - 1</tt>, or 0 if
+    *              \c first is 0.  On return, the digits of the last point.
+    */
+   static void fillBlock(const uint64_t* cols, Modulus first, Modulus count, uint64_t& x, uint64_t* block)
+   {
+      Modulus t = 0;
+      if (first == 0 and count > 0)
+         block[t++] = x = 0;
+      for (; t < count; t++) {
+         x ^= cols[trailingZeros(first + t)];
+         block[t] = x;
+      }
+   }
+
+   /**
+    * Generates the packed digits of the coordinate generated by \c gen for
+    * all points, in Gray-code order, and calls <tt>func(first, digits,
+    * count)</tt> for each block of at most blockSize() points starting at
+    * index \c first.
+    *
+    * The blocks end at the multiples of blockSize() and at firstPoint(), as
+    * in embeddedSums() followed by sumsTiled(), so that the sums over the
+    * blocks are the same as in merits().
+    */
+   template <class FUNC>
+   void forEachBlock(const Poly& gen, FUNC&& func) const
+   {
+      const auto cols = columns(gen);
+      const Modulus n = numPoints();
+      uint64_t block[blockSize()];
+      uint64_t x = 0;
+      Modulus count;
+      for (Modulus first = 0; first < n; first += count) {
+         count = first < firstPoint() ? std::min(blockSize(), firstPoint() - first) : blockCount(first);
+         fillBlock(cols.data(), first, count, x, block);
+         func(first, static_cast<const uint64_t*>(block), count);
+      }
+   }
+};
+
+/// Creates a component-by-component evaluator, with state vectors stored in
+/// \c storage, which can also be given as a Precision.
+template <class ACC = Functor::Sum, class KERNEL, class WEIGHTS>
+CoordUniformCBC<KERNEL, ACC>
+coordUniformCBC(SizeParam<LatType::ORDINARY> sizeParam, KERNEL kernel, const WEIGHTS& weights, const StateStorage& storage = StateStorage())
+{
+   const Modulus numPoints = sizeParam.numPoints();
+   return CoordUniformCBC<KERNEL, ACC>(
+         std::move(sizeParam),
+         std::move(kernel),
+         CoordUniformStateCreator::create(numPoints, weights, storage));
+}
+
+/// Creates a component-by-component evaluator that resumes the construction
+/// saved in the file at \c path, with state vectors stored in \c storage.
+template <class ACC = Functor::Sum, class KERNEL>
+CoordUniformCBC<KERNEL, ACC>
+coordUniformCBC(KERNEL kernel, const std::string& path, const StateStorage& storage = StateStorage())
+{ return CoordUniformCBC<KERNEL, ACC>(std::move(kernel), CBCState::load(path, storage)); }
+
+}}
+
+#endif
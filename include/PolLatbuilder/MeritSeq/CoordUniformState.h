@@ -0,0 +1,366 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__MERIT_SEQ__COORD_UNIFORM_STATE_H
+#define POLLATBUILDER__MERIT_SEQ__COORD_UNIFORM_STATE_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/Weights.h"
+#include "PolLatbuilder/MeritSeq/StateVector.h"
+#include "PolLatbuilder/detail/BinaryIO.h"
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include <unordered_map>
+
+namespace PolLatBuilder { namespace MeritSeq {
+
+/**
+ * Abstract state of a coordinate-uniform figure of merit evaluated
+ * coordinate by coordinate.
+ *
+ * The figure of merit of an \f$s\f$-dimensional point set with \f$n\f$ points
+ * \f$\boldsymbol x_0, \dots, \boldsymbol x_{n-1}\f$ is
+ * \f[
+ *    \frac1n \sum_{i=0}^{n-1} \sum_{\emptyset \neq \mathfrak u \subseteq
+ *    \{0, \dots, s-1\}} \gamma_{\mathfrak u} \prod_{j \in \mathfrak u}
+ *    \omega(x_{i,j}).
+ * \f]
+ * Appending a coordinate with kernel values \f$\omega_i\f$ adds
+ * \f$\frac1n \sum_i q_i \omega_i\f$ to it, where \f$\boldsymbol q\f$ is the
+ * weighted state vector returned by weightedState().  The state keeps the
+ * per-point information needed to compute \f$\boldsymbol q\f$ without
+ * revisiting the previous coordinates.
+ *
+ * Kernel values are indexed as the points of PointSet, in Gray-code order.
+ *
+ * The per-point vectors can be stored in single precision (see Precision)
+ * to halve their size.  They are still computed in double precision, and
+ * weightedState() carries a bound on the resulting error on
+ * \f$\boldsymbol q\f$ (see StateVector::error()), which
+ * CoordUniformCBC uses to switch back to double precision with
+ * setPrecision() when it becomes too large.
+ *
+ * They can also be stored in temporary files mapped in memory (see
+ * StateStorage) when they do not fit in memory.  Each update then streams
+ * through the vectors it reads and writes chunk by chunk, reading the next
+ * chunks ahead, so that its cost remains bounded by the disk bandwidth.
+ *
+ * States can be saved with save() and restored with
+ * CoordUniformStateCreator::load(), together with their weights, to append
+ * more coordinates later without revisiting the previous ones.
+ */
+class CoordUniformState {
+public:
+   /**
+    * Types of states, as recorded by save().
+    */
+   enum class Type : uint32_t { PRODUCT = 1, POD = 2, PROJECTION_DEPENDENT = 3 };
+
+   /**
+    * Constructor.
+    *
+    * \param numPoints  Number of points.
+    * \param storage    Storage of the per-point vectors.
+    */
+   explicit CoordUniformState(Modulus numPoints, const StateStorage& storage = StateStorage()):
+      m_numPoints(numPoints),
+      m_dimension(0),
+      m_storage(storage)
+   {}
+
+   virtual ~CoordUniformState()
+   {}
+
+   /**
+    * Returns the number of points.
+    */
+   Modulus numPoints() const
+   { return m_numPoints; }
+
+   /**
+    * Returns the number of coordinates appended so far.
+    */
+   Dimension dimension() const
+   { return m_dimension; }
+
+   /**
+    * Returns the storage of the per-point vectors.
+    */
+   const StateStorage& storage() const
+   { return m_storage; }
+
+   /**
+    * Returns the storage precision of the per-point vectors.
+    */
+   Precision precision() const
+   { return m_storage.precision; }
+
+   /**
+    * Converts the per-point vectors to \c precision.
+    *
+    * The error bounds accumulated in single precision are kept.
+    */
+   virtual void setPrecision(Precision precision)
+   { m_storage.precision = precision; }
+
+   /**
+    * Returns the number of bytes used by the per-point vectors.
+    */
+   virtual size_t bytes() const = 0;
+
+   /**
+    * Resets the state to dimension 0.
+    */
+   virtual void reset()
+   { m_dimension = 0; }
+
+   /**
+    * Appends a coordinate with kernel values \c kernelValues, stored in
+    * double precision.
+    */
+   virtual void update(const StateVector& /*kernelValues*/)
+   { m_dimension++; }
+
+   /**
+    * Returns the weighted state vector \f$\boldsymbol q\f$ for the next
+    * coordinate.
+    */
+   virtual const StateVector& weightedState() const = 0;
+
+   /**
+    * Returns a copy of this state.
+    */
+   virtual std::unique_ptr<CoordUniformState> clone() const = 0;
+
+   /**
+    * Writes the state and its weights to \c os in binary form, in the native
+    * byte order.
+    *
+    * The vectors are written in double precision, block by block, with
+    * their error bounds (see StateVector::error()), and their storage is not
+    * recorded: it is chosen when the state is restored.
+    */
+   virtual void save(std::ostream& os) const = 0;
+
+protected:
+   /**
+    * Writes the type, number of points and dimension of the state.
+    */
+   void saveHeader(std::ostream& os, Type type) const;
+
+   /**
+    * Sets the dimension of a state restored by
+    * CoordUniformStateCreator::load().
+    */
+   void setDimension(Dimension dimension)
+   { m_dimension = dimension; }
+
+private:
+   Modulus m_numPoints;
+   Dimension m_dimension;
+   StateStorage m_storage;
+};
+
+/**
+ * State for product weights.
+ *
+ * Keeps a single vector \f$p_i = \prod_{j} (1 + \gamma_j \omega(x_{i,j}))\f$,
+ * so that \f$q_i = \gamma_s p_i\f$ and each update costs \f$O(n)\f$.
+ */
+class ProductState : public CoordUniformState {
+public:
+   ProductState(Modulus numPoints, ProductWeights weights, const StateStorage& storage = StateStorage());
+
+   void setPrecision(Precision precision) override;
+   size_t bytes() const override
+   { return m_state.bytes() + m_weightedState.bytes(); }
+   void reset() override;
+   void update(const StateVector& kernelValues) override;
+   const StateVector& weightedState() const override
+   { return m_weightedState; }
+   std::unique_ptr<CoordUniformState> clone() const override
+   { return std::unique_ptr<CoordUniformState>(new ProductState(*this)); }
+   void save(std::ostream& os) const override;
+
+   /**
+    * Reads the weights and vectors written by save() after the header, and
+    * stores the vectors in \c storage.
+    */
+   static std::unique_ptr<CoordUniformState> load(detail::BinaryReader& in, Modulus numPoints, Dimension dimension, const StateStorage& storage);
+
+   const ProductWeights& weights() const
+   { return m_weights; }
+
+private:
+   ProductWeights m_weights;
+   StateVector m_state;
+   StateVector m_weightedState;
+
+   void updateWeightedState();
+};
+
+/**
+ * State for POD weights, which include order-dependent weights.
+ *
+ * Keeps one vector per interaction order \f$\ell\f$:
+ * \f[
+ *    p_{\ell,i} = \sum_{|\mathfrak u| = \ell} \prod_{j \in \mathfrak u}
+ *    \gamma_j \omega(x_{i,j}),
+ * \f]
+ * so that
+ * \f$q_i = \gamma_s \sum_{\ell \geq 1} \Gamma_\ell \, p_{\ell-1,i}\f$, with
+ * \f$p_{0,i} = 1\f$, and appending a coordinate updates
+ * \f$p_{\ell,i} \mathrel{+}= \gamma_s \omega_i \, p_{\ell-1,i}\f$ in
+ * \f$O(n \ell_{\max})\f$ operations.  If the weights are truncated at order
+ * \f$L\f$ (see OrderDependentWeights::maxOrder()), only orders below \f$L\f$
+ * are stored; otherwise, the number of vectors grows with the dimension.
+ */
+class PODState : public CoordUniformState {
+public:
+   PODState(Modulus numPoints, PODWeights weights, const StateStorage& storage = StateStorage());
+
+   void setPrecision(Precision precision) override;
+   size_t bytes() const override;
+   void reset() override;
+   void update(const StateVector& kernelValues) override;
+   const StateVector& weightedState() const override
+   { return m_weightedState; }
+   std::unique_ptr<CoordUniformState> clone() const override
+   { return std::unique_ptr<CoordUniformState>(new PODState(*this)); }
+   void save(std::ostream& os) const override;
+
+   /**
+    * Reads the weights and vectors written by save() after the header, and
+    * stores the vectors in \c storage.
+    */
+   static std::unique_ptr<CoordUniformState> load(detail::BinaryReader& in, Modulus numPoints, Dimension dimension, const StateStorage& storage);
+
+   const PODWeights& weights() const
+   { return m_weights; }
+
+   /**
+    * Returns the number of stored per-order vectors.
+    */
+   Dimension numOrders() const
+   { return m_state.size(); }
+
+private:
+   PODWeights m_weights;
+   /// per-order state vectors, for orders 1, 2, ...
+   std::vector<StateVector> m_state;
+   StateVector m_weightedState;
+
+   void updateWeightedState();
+};
+
+/**
+ * State for projection-dependent weights.
+ *
+ * For each projection \f$\mathfrak u\f$ with a nonzero weight, the products
+ * \f$\prod_{j \in \mathfrak v} \omega(x_{i,j})\f$ over the subsets
+ * \f$\mathfrak v\f$ of \f$\mathfrak u\f$ formed by its coordinates up to
+ * some dimension are kept in a hash table indexed by the bit mask of
+ * \f$\mathfrak v\f$.  Partial products shared by several projections are
+ * stored once, each one is computed from the previous one as coordinates
+ * are appended, and it is discarded when no remaining projection needs it.
+ * The weighted state for coordinate \f$c\f$ is
+ * \f$q_i = \sum_{\max \mathfrak u = c} \gamma_{\mathfrak u}
+ * \prod_{j \in \mathfrak u \setminus \{c\}} \omega(x_{i,j})\f$.
+ *
+ * The cost of each update and the memory usage are proportional to the number
+ * of weighted projections, not to \f$2^s\f$.
+ */
+class ProjectionDependentState : public CoordUniformState {
+public:
+   ProjectionDependentState(Modulus numPoints, ProjectionDependentWeights weights, const StateStorage& storage = StateStorage());
+
+   void setPrecision(Precision precision) override;
+   size_t bytes() const override;
+   void reset() override;
+   void update(const StateVector& kernelValues) override;
+   const StateVector& weightedState() const override
+   { return m_weightedState; }
+   std::unique_ptr<CoordUniformState> clone() const override
+   { return std::unique_ptr<CoordUniformState>(new ProjectionDependentState(*this)); }
+   void save(std::ostream& os) const override;
+
+   /**
+    * Reads the weights and vectors written by save() after the header, and
+    * stores the vectors in \c storage.
+    */
+   static std::unique_ptr<CoordUniformState> load(detail::BinaryReader& in, Modulus numPoints, Dimension dimension, const StateStorage& storage);
+
+   const ProjectionDependentWeights& weights() const
+   { return m_weights; }
+
+   /**
+    * Returns the number of partial products currently cached.
+    */
+   size_t cacheSize() const
+   { return m_cache.size(); }
+
+private:
+   struct WeightedProjection {
+      /// projection without its largest coordinate
+      ProjectionMask rest;
+      Real weight;
+   };
+
+   ProjectionDependentWeights m_weights;
+   /// weighted projections, by largest coordinate
+   std::vector<std::vector<WeightedProjection>> m_projections;
+   /// partial products to compute when appending each coordinate
+   std::vector<std::vector<ProjectionMask>> m_partials;
+   /// last coordinate needing each partial product
+   std::unordered_map<ProjectionMask, Dimension> m_lastUse;
+   /// cached partial products
+   std::unordered_map<ProjectionMask, StateVector> m_cache;
+   StateVector m_weightedState;
+
+   void updateWeightedState();
+};
+
+/**
+ * Creation of coordinate-uniform states from weights.
+ */
+struct CoordUniformStateCreator {
+   static std::unique_ptr<CoordUniformState> create(Modulus numPoints, const ProductWeights& weights, const StateStorage& storage = StateStorage())
+   { return std::unique_ptr<CoordUniformState>(new ProductState(numPoints, weights, storage)); }
+
+   static std::unique_ptr<CoordUniformState> create(Modulus numPoints, const OrderDependentWeights& weights, const StateStorage& storage = StateStorage())
+   { return std::unique_ptr<CoordUniformState>(new PODState(numPoints, PODWeights(weights, ProductWeights(1.0)), storage)); }
+
+   static std::unique_ptr<CoordUniformState> create(Modulus numPoints, const PODWeights& weights, const StateStorage& storage = StateStorage())
+   { return std::unique_ptr<CoordUniformState>(new PODState(numPoints, weights, storage)); }
+
+   static std::unique_ptr<CoordUniformState> create(Modulus numPoints, const ProjectionDependentWeights& weights, const StateStorage& storage = StateStorage())
+   { return std::unique_ptr<CoordUniformState>(new ProjectionDependentState(numPoints, weights, storage)); }
+
+   /**
+    * Restores a state written with CoordUniformState::save(), with its
+    * vectors stored in \c storage.
+    *
+    * Throws \c std::runtime_error if the data is truncated or invalid.
+    */
+   static std::unique_ptr<CoordUniformState> load(detail::BinaryReader& in, const StateStorage& storage = StateStorage());
+};
+
+}}
+
+#endif
@@ -0,0 +1,324 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__MERIT_SEQ__STATE_VECTOR_H
+#define POLLATBUILDER__MERIT_SEQ__STATE_VECTOR_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/MappedFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace PolLatBuilder { namespace MeritSeq {
+
+/**
+ * Storage precision of the per-point vectors of a CoordUniformState.
+ *
+ * - \c DOUBLE: elements are stored as \c Real.
+ * - \c SINGLE: elements are computed in double precision but stored as \c
+ *   float, which halves the memory used by the state and the memory traffic
+ *   of each evaluation, at the cost of a relative rounding error of at most
+ *   \f$2^{-24}\f$ on each stored element.
+ */
+enum class Precision { DOUBLE, SINGLE };
+
+/**
+ * Storage of the per-point vectors of a CoordUniformState.
+ *
+ * By default, vectors are stored in memory.  Vectors created with mapped()
+ * are stored instead in temporary files in a given directory, mapped in
+ * memory (see MappedTempFile), so that the state can exceed the physical
+ * memory: the kernel writes the pages back to the files and reads them again
+ * on demand.  These vectors are processed sequentially in chunks of
+ * chunkBytes bytes, and the next chunk is read ahead while the current one
+ * is processed (see StateVector::prefetch()).
+ */
+struct StateStorage {
+   /**
+    * Constructor for vectors stored in memory in \c precision.
+    */
+   StateStorage(Precision precision = Precision::DOUBLE):
+      precision(precision),
+      chunkBytes(0)
+   {}
+
+   /**
+    * Returns a storage in temporary files in \c directory, which should be
+    * on a local disk.
+    *
+    * \param chunkBytes Size of the chunks read ahead, or 0 for
+    *                   defaultChunkBytes().
+    */
+   static StateStorage mapped(std::string directory, Precision precision = Precision::DOUBLE, size_t chunkBytes = 0)
+   {
+      StateStorage storage(precision);
+      storage.directory = std::move(directory);
+      storage.chunkBytes = chunkBytes;
+      return storage;
+   }
+
+   /**
+    * Returns \c true if vectors are stored in temporary files.
+    */
+   bool isMapped() const
+   { return not directory.empty(); }
+
+   /**
+    * Returns the default chunk size: half of the last-level cache, so that
+    * the chunk being processed and the chunk being read ahead fit in it
+    * together, rounded down to a multiple of the page size.  If the cache
+    * size cannot be determined, a cache of 8 MiB is assumed.
+    */
+   static size_t defaultChunkBytes();
+
+   Precision precision;
+   /// Directory of the temporary files, or empty for storage in memory.
+   std::string directory;
+   size_t chunkBytes;
+};
+
+/**
+ * Per-point vector of a coordinate-uniform state, stored in single or double
+ * precision, in memory or in a temporary file (see StateStorage).
+ *
+ * Elements are always computed in double precision: they are updated with
+ * transform(), whose loop is compiled once for each storage type, and read
+ * one at a time or converted block by block with block().  Both visit the
+ * elements in increasing order and announce the next chunk of a mapped
+ * vector to the kernel before it is needed.
+ *
+ * Each vector also carries a bound on the absolute error of its elements
+ * with respect to the values that would be obtained with double-precision
+ * storage (see error()).  The rounding errors of the storage are measured by
+ * transform(), and the state that owns the vector combines them with the
+ * propagated errors of the previous values.  Rounding errors of
+ * double-precision arithmetic are not included.
+ */
+class StateVector {
+public:
+   /**
+    * Constructor for an empty vector.
+    */
+   explicit StateVector(const StateStorage& storage = StateStorage()):
+      m_storage(storage),
+      m_size(0),
+      m_data(nullptr),
+      m_allocated(0),
+      m_error(0.0)
+   {}
+
+   /**
+    * Constructor for a vector of \c size elements equal to \c value.
+    */
+   StateVector(Modulus size, Real value, const StateStorage& storage = StateStorage()):
+      StateVector(storage)
+   { assign(size, value); }
+
+   /**
+    * Constructor from double-precision values.
+    */
+   StateVector(const Real* first, const Real* last, const StateStorage& storage = StateStorage());
+
+   StateVector(const StateVector& other);
+   StateVector& operator=(const StateVector& other);
+   StateVector(StateVector&& other);
+   StateVector& operator=(StateVector&& other);
+
+   const StateStorage& storage() const
+   { return m_storage; }
+
+   Precision precision() const
+   { return m_storage.precision; }
+
+   Modulus size() const
+   { return m_size; }
+
+   bool empty() const
+   { return m_size == 0; }
+
+   /**
+    * Returns the number of bytes used by the elements, in memory or on disk.
+    */
+   size_t bytes() const
+   { return m_size * elementSize(); }
+
+   /**
+    * Sets the vector to \c size elements equal to \c value.
+    *
+    * The error bound is set to the rounding error on \c value.
+    */
+   void assign(Modulus size, Real value);
+
+   /**
+    * Removes all elements and releases their space.
+    */
+   void clear();
+
+   /**
+    * Returns element \c i in double precision.
+    */
+   Real operator[](Modulus i) const
+   {
+      if (precision() == Precision::SINGLE)
+         return static_cast<const float*>(m_data)[i];
+      return static_cast<const Real*>(m_data)[i];
+   }
+
+   /**
+    * Returns a pointer to the elements of a vector stored in double
+    * precision.
+    */
+   Real* data()
+   { return static_cast<Real*>(m_data); }
+
+   /// \copydoc data()
+   const Real* data() const
+   { return static_cast<const Real*>(m_data); }
+
+   /**
+    * Returns a pointer to the elements \c first to <tt>first + count -
+    * 1</tt> in double precision: a pointer into the vector itself if it is
+    * stored in double precision, or \c buffer, which must have room for
+    * \c count elements, after converting them.
+    */
+   const Real* block(Modulus first, Modulus count, Real* buffer) const
+   {
+      prefetch(first, count);
+      if (precision() == Precision::DOUBLE)
+         return data() + first;
+      const float* x = static_cast<const float*>(m_data) + first;
+      for (Modulus i = 0; i < count; i++)
+         buffer[i] = x[i];
+      return buffer;
+   }
+
+   /**
+    * Announces that the elements \c first to <tt>first + count - 1</tt> are
+    * about to be processed in increasing order.
+    *
+    * If the vector is mapped and this range starts a new chunk, the next
+    * chunk is read ahead asynchronously, so that at most two chunks are in
+    * transit at any time: the one being processed and the next one.  The
+    * whole mapping is also marked for sequential access, so that the kernel
+    * can reclaim the chunks already processed first.
+    */
+   void prefetch(Modulus first, Modulus count) const
+   {
+      if (not m_mapping or count == 0)
+         return;
+      const Modulus chunk = chunkSize();
+      const Modulus last = (first + count - 1) / chunk;
+      if (first == 0 or (first - 1) / chunk != last)
+         m_mapping->advise(MappedFile::Access::WILLNEED, (last + 1) * chunk * elementSize(), chunk * elementSize());
+   }
+
+   /**
+    * Sets each element \f$x_i\f$ to <tt>func(i, x_i)</tt>, computed in double
+    * precision, and returns the largest rounding error on the stored values,
+    * which is 0 in double precision.
+    *
+    * The elements are processed in increasing order, chunk by chunk, and
+    * the corresponding chunks of the vectors in \c sources, read by \c func,
+    * are prefetched together with those of this vector.
+    */
+   template <class FUNC>
+   Real transform(FUNC&& func, const std::vector<const StateVector*>& sources = {})
+   {
+      if (precision() == Precision::SINGLE)
+         return transform(static_cast<float*>(m_data), func, sources);
+      return transform(static_cast<Real*>(m_data), func, sources);
+   }
+
+   /**
+    * Returns a copy of the elements in double precision, in memory.
+    */
+   RealVector toReal() const;
+
+   /**
+    * Converts the elements to \c precision.
+    *
+    * Conversion to single precision adds the rounding errors to the error
+    * bound; conversion to double precision is exact and keeps it.
+    */
+   void setPrecision(Precision precision);
+
+   /**
+    * Returns the bound on the absolute error of the elements due to storage
+    * in single precision.
+    */
+   Real error() const
+   { return m_error; }
+
+   /**
+    * Sets the error bound returned by error().
+    */
+   void setError(Real error)
+   { m_error = error; }
+
+private:
+   StateStorage m_storage;
+   Modulus m_size;
+   std::unique_ptr<char[]> m_memory;
+   std::unique_ptr<MappedTempFile> m_mapping;
+   /// first element, in m_memory or m_mapping
+   void* m_data;
+   /// size of the space at m_data in bytes
+   size_t m_allocated;
+   Real m_error;
+
+   size_t elementSize() const
+   { return precision() == Precision::SINGLE ? sizeof(float) : sizeof(Real); }
+
+   /**
+    * Returns the number of elements per chunk, or the size of the vector if
+    * it is stored in memory.
+    */
+   Modulus chunkSize() const;
+
+   /**
+    * Makes room for \c size elements in the current storage.  Returns \c
+    * true if new space was allocated, uninitialized in memory or
+    * zero-filled in a file, and \c false if the previous space was reused.
+    */
+   bool allocate(Modulus size);
+
+   template <typename T, class FUNC>
+   Real transform(T* x, FUNC& func, const std::vector<const StateVector*>& sources)
+   {
+      Real error = 0.0;
+      const Modulus chunk = chunkSize();
+      for (Modulus first = 0; first < m_size; first += chunk) {
+         const Modulus count = std::min(chunk, m_size - first);
+         prefetch(first, count);
+         for (const auto source : sources)
+            source->prefetch(first, count);
+         for (Modulus i = first; i < first + count; i++) {
+            const Real y = func(i, Real(x[i]));
+            x[i] = T(y);
+            error = std::max(error, std::abs(Real(x[i]) - y));
+         }
+      }
+      return error;
+   }
+};
+
+}}
+
+#endif
@@ -0,0 +1,196 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__MODULAR_POLY_H
+#define POLLATBUILDER__MODULAR_POLY_H
+
+#include "PolLatbuilder/Types.h"
+
+#include <NTL/GF2X.h>
+
+#include <memory>
+#include <ostream>
+
+namespace PolLatBuilder {
+
+/**
+ * Immutable description of a modulus for ModularPoly values.
+ *
+ * Besides the polynomial, it holds the precomputed data used by NTL for fast
+ * reductions.  It is shared, read-only, by all values modulo the same
+ * polynomial, which makes these values usable from any thread.
+ */
+class PolyModulus {
+public:
+   /**
+    * Constructor.
+    *
+    * \param polynomial    Modulus; its degree must be positive.
+    */
+   explicit PolyModulus(Poly polynomial);
+
+   /**
+    * Creates a shared modulus descriptor for \c polynomial.
+    */
+   static std::shared_ptr<const PolyModulus> create(Poly polynomial)
+   { return std::make_shared<const PolyModulus>(std::move(polynomial)); }
+
+   /**
+    * Returns the polynomial.
+    */
+   const Poly& polynomial() const
+   { return m_polynomial; }
+
+   /**
+    * Returns the degree of the polynomial.
+    */
+   long degree() const
+   { return deg(m_polynomial); }
+
+   /**
+    * Returns the precomputed reduction data.
+    */
+   const NTL::GF2XModulus& reducer() const
+   { return m_reducer; }
+
+private:
+   Poly m_polynomial;
+   NTL::GF2XModulus m_reducer;
+};
+
+/**
+ * Polynomial over \f$\mathbb{F}_2\f$ modulo a polynomial \f$P\f$, carrying
+ * its modulus.
+ *
+ * Contrary to PolyModP, whose modulus is that of the NTL context of the
+ * calling thread, a ModularPoly refers to a shared PolyModulus descriptor,
+ * so that values modulo different polynomials can be created and combined
+ * by any thread, without initializing or switching the NTL context.
+ * Operations on values with different moduli throw \c std::runtime_error.
+ *
+ * A default-constructed value is zero and has no modulus; it can only be
+ * assigned to.
+ */
+class ModularPoly {
+public:
+   typedef std::shared_ptr<const PolyModulus> ModulusPtr;
+
+   ModularPoly() = default;
+
+   /**
+    * Constructor for \c value modulo \c modulus.
+    */
+   ModularPoly(ModulusPtr modulus, const Poly& value);
+
+   /**
+    * Returns \c value, whose degree must be smaller than that of \c modulus,
+    * without reducing it.
+    */
+   static ModularPoly fromReduced(ModulusPtr modulus, Poly value)
+   {
+      ModularPoly x;
+      x.m_modulus = std::move(modulus);
+      x.m_rep = std::move(value);
+      return x;
+   }
+
+   /**
+    * Returns the modulus descriptor, or a null pointer for a
+    * default-constructed value.
+    */
+   const ModulusPtr& modulus() const
+   { return m_modulus; }
+
+   /**
+    * Returns the representative of degree smaller than that of the modulus.
+    */
+   const Poly& residue() const
+   { return m_rep; }
+
+   /**
+    * Returns this value as a PolyModP, without reducing it.
+    *
+    * The result can be stored, for example in a GeneratingVector, by any
+    * thread; arithmetic on it requires a PolyModP context with the same
+    * modulus.
+    */
+   PolyModP toPolyModP() const
+   {
+      PolyModP x;
+      x.LoopHole() = m_rep;
+      return x;
+   }
+
+   /**
+    * Returns \c true if \c a and \c b have the same modulus.
+    */
+   static bool sameModulus(const ModularPoly& a, const ModularPoly& b)
+   {
+      return a.m_modulus == b.m_modulus or (a.m_modulus and b.m_modulus
+            and a.m_modulus->polynomial() == b.m_modulus->polynomial());
+   }
+
+   ModularPoly& operator+=(const ModularPoly& other);
+   ModularPoly& operator*=(const ModularPoly& other);
+
+private:
+   ModulusPtr m_modulus;
+   Poly m_rep;
+};
+
+/**
+ * Returns the representative of \c x of degree smaller than that of its
+ * modulus, as <tt>rep()</tt> does for PolyModP.
+ */
+inline const Poly& rep(const ModularPoly& x)
+{ return x.residue(); }
+
+inline bool IsZero(const ModularPoly& x)
+{ return IsZero(x.residue()); }
+
+inline ModularPoly operator+(ModularPoly a, const ModularPoly& b)
+{ return a += b; }
+
+inline ModularPoly operator-(ModularPoly a, const ModularPoly& b)
+{ return a += b; }
+
+inline ModularPoly operator*(ModularPoly a, const ModularPoly& b)
+{ return a *= b; }
+
+inline bool operator==(const ModularPoly& a, const ModularPoly& b)
+{ return ModularPoly::sameModulus(a, b) and a.residue() == b.residue(); }
+
+inline bool operator!=(const ModularPoly& a, const ModularPoly& b)
+{ return not (a == b); }
+
+/**
+ * Returns the inverse of \c x.
+ *
+ * Throws \c std::runtime_error if \c x is not coprime with its modulus.
+ */
+ModularPoly inv(const ModularPoly& x);
+
+/**
+ * Returns \c x raised to the power \c e, which can be negative if \c x is
+ * invertible.
+ */
+ModularPoly power(const ModularPoly& x, long e);
+
+std::ostream& operator<<(std::ostream& os, const ModularPoly& x);
+
+}
+
+#endif
@@ -0,0 +1,216 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__MULTI_MODULUS_SEARCH_H
+#define POLLATBUILDER__MULTI_MODULUS_SEARCH_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/LatDef.h"
+#include "PolLatbuilder/ModularPoly.h"
+#include "PolLatbuilder/GenSeq/CoprimePolynomials.h"
+#include "PolLatbuilder/GenSeq/Modular.h"
+#include "PolLatbuilder/MeritSeq/CoordUniformCBC.h"
+#include "PolLatbuilder/Parallel/BlockCursor.h"
+#include "PolLatbuilder/Parallel/SharedBound.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace PolLatBuilder {
+
+/**
+ * Construction methods for multiModulusSearch().
+ */
+enum class SearchMethod {
+   /// Component-by-component construction.
+   CBC,
+   /// Exhaustive search of Korobov lattices.
+   KOROBOV
+};
+
+/**
+ * Best lattice found for one modulus by multiModulusSearch().
+ */
+struct ModulusSearchResult {
+   /// Index of the size parameter in the input of multiModulusSearch().
+   size_t index;
+   /// Best lattice; for a pruned modulus, the components selected before
+   /// the search was abandoned.
+   LatDef<LatType::ORDINARY> lat;
+   /// Merit of \c lat, or infinity if the modulus was pruned.
+   Real merit;
+
+   /// Returns \c true if the search was abandoned because no lattice with
+   /// this modulus could beat the best one of another modulus.
+   bool pruned() const
+   { return std::isinf(merit); }
+};
+
+/**
+ * Results of multiModulusSearch().
+ */
+struct MultiModulusResult {
+   /// Results for all moduli, by increasing merit, then by increasing index;
+   /// pruned moduli come last.  Only the first one is guaranteed to be the
+   /// best lattice for its modulus.
+   std::vector<ModulusSearchResult> ranking;
+
+   /// Returns the best lattice over all moduli.
+   const ModulusSearchResult& best() const
+   {
+      if (ranking.empty() or ranking.front().pruned())
+         throw std::runtime_error("MultiModulusResult: no lattice found");
+      return ranking.front();
+   }
+};
+
+/**
+ * Searches for the best lattice of dimension \c dimension for each of the
+ * size parameters in \c sizeParams, concurrently, and ranks the results.
+ *
+ * The moduli are distributed dynamically over \c numThreads threads (all
+ * processors if 0), each one searching a modulus at a time with a
+ * CoordUniformCBC evaluator and the sequence of polynomials coprime with the
+ * modulus.  The threads share the best merit found so far over all moduli:
+ * a CBC construction is abandoned as soon as its partial merit exceeds it,
+ * and the Korobov lattices are evaluated with early abandoning against it.
+ * This requires nonnegative contributions of the coordinates, as for
+ * CoordUniformCBC::evaluate() with a bound.  Pruning never discards a
+ * lattice better than the best one, so the winner is the same as with
+ * independent searches and does not depend on the scheduling; the other
+ * moduli may be pruned, or report the best lattice found before the bound
+ * dropped below their merits, depending on the order of completion.
+ *
+ * The searches use ModularPoly values, so the PolyModP context of the
+ * threads is never used and the moduli can differ in degree.
+ *
+ * Throws \c std::runtime_error if a modulus degree is not in 1..63.  An
+ * exception thrown while searching stops the other threads after their
+ * current modulus and is rethrown once they have finished.
+ *
+ * \tparam ACC    Accumulator of the figure of merit.
+ */
+template <class ACC = Functor::Sum, class KERNEL, class WEIGHTS>
+MultiModulusResult multiModulusSearch(
+      const std::vector<SizeParam<LatType::ORDINARY>>& sizeParams,
+      const KERNEL& kernel,
+      const WEIGHTS& weights,
+      Dimension dimension,
+      SearchMethod method = SearchMethod::CBC,
+      unsigned numThreads = 0)
+{
+   if (dimension == 0)
+      throw std::runtime_error("multiModulusSearch: dimension must be positive");
+   for (const auto& sizeParam : sizeParams) {
+      const long degree = deg(sizeParam.polynomial());
+      if (degree < 1 or degree > 63)
+         throw std::runtime_error("multiModulusSearch: modulus degree must be in 1..63");
+   }
+
+   MultiModulusResult result;
+   for (size_t k = 0; k < sizeParams.size(); k++)
+      result.ranking.push_back(ModulusSearchResult{
+            k, createLatDef(sizeParams[k]), std::numeric_limits<Real>::infinity()});
+
+   Parallel::SharedBound bound;
+   Parallel::BlockCursor cursor(sizeParams.size(), 1);
+
+   auto searchCBC = [&](ModulusSearchResult& res, const GenSeq::Modular<GenSeq::CoprimePolynomials<>>& seq) {
+      auto cbc = MeritSeq::coordUniformCBC<ACC>(sizeParams[res.index], kernel, weights);
+      for (Dimension j = 0; j < dimension; j++) {
+         cbc.selectBest(seq);
+         if (cbc.exceeds(bound.get())) {
+            res.lat = cbc.baseLat();
+            return;
+         }
+      }
+      res.lat = cbc.baseLat();
+      res.merit = cbc.baseMerit();
+      bound.improve(res.merit);
+   };
+
+   auto searchKorobov = [&](ModulusSearchResult& res, const GenSeq::Modular<GenSeq::CoprimePolynomials<>>& seq) {
+      auto cbc = MeritSeq::coordUniformCBC<ACC>(sizeParams[res.index], kernel, weights);
+      const auto one = ModularPoly(seq.modulus(), Poly(1));
+      auto lat = createLatDef(sizeParams[res.index]);
+      for (const auto& a : seq) {
+         lat.gen().clear();
+         for (ModularPoly g = one; lat.gen().size() < dimension; g *= a)
+            lat.gen().push_back(g.toPolyModP());
+         const Real merit = cbc.evaluate(lat, bound);
+         // ties are resolved in favor of the first generator
+         if (merit < res.merit) {
+            res.merit = merit;
+            res.lat = lat;
+            bound.improve(merit);
+         }
+      }
+   };
+
+   // the first exception thrown by a worker, rethrown after all threads
+   // have joined
+   std::exception_ptr error;
+   std::mutex errorMutex;
+
+   auto worker = [&]() {
+      try {
+         size_t first, count;
+         while (cursor.next(first, count)) {
+            auto& res = result.ranking[first];
+            const Poly& P = sizeParams[first].polynomial();
+            const GenSeq::Modular<GenSeq::CoprimePolynomials<>> seq(
+                  PolyModulus::create(P), GenSeq::CoprimePolynomials<>(P));
+            if (method == SearchMethod::CBC)
+               searchCBC(res, seq);
+            else
+               searchKorobov(res, seq);
+         }
+      }
+      catch (...) {
+         std::lock_guard<std::mutex> lock(errorMutex);
+         if (not error)
+            error = std::current_exception();
+         cursor.stop();
+      }
+   };
+
+   if (numThreads == 0)
+      numThreads = std::thread::hardware_concurrency();
+   numThreads = std::max(1u, std::min<unsigned>(numThreads, sizeParams.size()));
+   std::vector<std::thread> threads;
+   for (unsigned i = 1; i < numThreads; i++)
+      threads.emplace_back(worker);
+   worker();
+   for (auto& t : threads)
+      t.join();
+   if (error)
+      std::rethrow_exception(error);
+
+   std::sort(result.ranking.begin(), result.ranking.end(),
+         [](const ModulusSearchResult& a, const ModulusSearchResult& b)
+         { return a.merit < b.merit or (a.merit == b.merit and a.index < b.index); });
+   return result;
+}
+
+}
+
+#endif
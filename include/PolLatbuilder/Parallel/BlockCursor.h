@@ -0,0 +1,112 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__PARALLEL__BLOCK_CURSOR_H
+#define POLLATBUILDER__PARALLEL__BLOCK_CURSOR_H
+
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+
+namespace PolLatBuilder { namespace Parallel {
+
+/**
+ * Lock-free dispenser of disjoint blocks of indices.
+ *
+ * The range \f$[0, size)\f$ is cut into consecutive blocks of \c blockSize
+ * indices, which are handed out to concurrent consumers with a single atomic
+ * fetch-and-add each.  Every index is handed out exactly once.
+ *
+ * Typical usage in each consumer thread:
+ * \code
+ * size_t first, count;
+ * while (cursor.next(first, count))
+ *    process(first, count);
+ * \endcode
+ */
+class BlockCursor {
+public:
+   typedef size_t size_type;
+
+   /**
+    * Constructor.
+    *
+    * \param size       Number of indices.
+    * \param blockSize  Number of indices per block (the last block may be
+    *                   shorter).
+    */
+   BlockCursor(size_type size, size_type blockSize):
+      m_size(size),
+      m_blockSize(std::max<size_type>(blockSize, 1)),
+      m_next(0)
+   {}
+
+   BlockCursor(const BlockCursor&) = delete;
+   BlockCursor& operator=(const BlockCursor&) = delete;
+
+   /**
+    * Returns the number of indices.
+    */
+   size_type size() const
+   { return m_size; }
+
+   /**
+    * Returns the number of indices per block.
+    */
+   size_type blockSize() const
+   { return m_blockSize; }
+
+   /**
+    * Claims the next block.
+    *
+    * Returns \c false if all blocks have already been handed out; otherwise,
+    * sets \c first and \c count to the claimed block and returns \c true.
+    */
+   bool next(size_type& first, size_type& count)
+   {
+      // cheap test to avoid incrementing the counter without bound
+      if (m_next.load(std::memory_order_relaxed) >= m_size)
+         return false;
+      first = m_next.fetch_add(m_blockSize, std::memory_order_relaxed);
+      if (first >= m_size)
+         return false;
+      count = std::min(m_blockSize, m_size - first);
+      return true;
+   }
+
+   /**
+    * Hands out no more blocks; the blocks already claimed are not affected.
+    */
+   void stop()
+   { m_next.store(m_size, std::memory_order_relaxed); }
+
+   /**
+    * Makes all blocks available again.
+    *
+    * Must not be called while other threads use the cursor.
+    */
+   void reset()
+   { m_next.store(0); }
+
+private:
+   const size_type m_size;
+   const size_type m_blockSize;
+   std::atomic<size_type> m_next;
+};
+
+}}
+
+#endif
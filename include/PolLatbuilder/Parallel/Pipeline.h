@@ -0,0 +1,393 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__PARALLEL__PIPELINE_H
+#define POLLATBUILDER__PARALLEL__PIPELINE_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/Parallel/BlockCursor.h"
+#include "PolLatbuilder/Parallel/RingBuffer.h"
+#include "PolLatbuilder/Parallel/SharedBound.h"
+
+#include <NTL/GF2E.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PolLatBuilder { namespace Parallel {
+
+/**
+ * Activity of the threads of one stage of a Pipeline.
+ */
+struct StageStats {
+   /// Number of threads.
+   unsigned threads = 0;
+   /// Number of items (candidates or batch winners) processed.
+   size_t items = 0;
+   /// Time spent working, summed over the threads, in seconds.
+   double busySeconds = 0.0;
+   /// Time spent waiting for input or for space in the output queue,
+   /// summed over the threads, in seconds.
+   double waitSeconds = 0.0;
+
+   /**
+    * Returns the fraction of the time the threads of the stage were busy.
+    */
+   double utilization() const
+   { return busySeconds + waitSeconds > 0.0 ? busySeconds / (busySeconds + waitSeconds) : 0.0; }
+};
+
+/**
+ * Statistics of the last run of a Pipeline.
+ */
+struct PipelineStats {
+   StageStats producers;
+   StageStats evaluators;
+   StageStats reducer;
+   /// Wall-clock time of the run, in seconds.
+   double elapsedSeconds = 0.0;
+};
+
+/**
+ * Search that overlaps the generation of the candidates with their
+ * evaluation.
+ *
+ * The search runs three stages concurrently:
+ * - producer threads claim blocks of candidate indices with a BlockCursor,
+ *   generate the candidates into batches and push the batches to a bounded
+ *   RingBuffer;
+ * - evaluator threads pop the batches, compute the merits of their
+ *   candidates and pass the best candidate of each batch to the reducer
+ *   through a second queue;
+ * - a reducer thread keeps the best candidate overall and lowers a
+ *   SharedBound that the evaluators can use to abandon evaluations early.
+ *
+ * The batches come from a fixed pool of queueCapacity() buffers, recycled
+ * through a queue of free batches: producers that get ahead of the
+ * evaluators wait for a free batch, which bounds the memory used and keeps
+ * the producers from competing with the evaluators for the processors.
+ * The time each stage spends waiting is reported in stats(); with enough
+ * producers, the evaluators never wait and generation is hidden behind
+ * evaluation.
+ *
+ * The result does not depend on the scheduling: ties are resolved in favor
+ * of the smallest index.  The PolyModP context of the calling thread is
+ * installed in all threads.
+ *
+ * \tparam VALUE  Type of the candidates; must be default-constructible and
+ *                copyable.
+ */
+template <typename VALUE>
+class Pipeline {
+public:
+   typedef VALUE value_type;
+
+   /**
+    * Best candidate found by run().
+    */
+   struct Winner {
+      /// Index of the candidate, or \c std::numeric_limits<size_t>::max() if
+      /// no candidate was found.
+      size_t index = std::numeric_limits<size_t>::max();
+      value_type value{};
+      Real merit = std::numeric_limits<Real>::infinity();
+
+      bool found() const
+      { return index != std::numeric_limits<size_t>::max(); }
+
+      /// Returns \c true if this candidate is better than \c other.
+      bool beats(const Winner& other) const
+      { return merit < other.merit or (merit == other.merit and index < other.index); }
+   };
+
+   /**
+    * Constructor.
+    *
+    * \param numProducers      Number of producer threads; at least 1.
+    * \param numEvaluators     Number of evaluator threads; 0 for the number
+    *                          of processors minus the producers.
+    * \param batchSize         Number of candidates per batch.
+    * \param queueCapacity     Number of batches in flight.
+    */
+   explicit Pipeline(
+         unsigned numProducers = 1,
+         unsigned numEvaluators = 0,
+         size_t batchSize = 64,
+         size_t queueCapacity = 16):
+      m_numProducers(std::max(1u, numProducers)),
+      m_numEvaluators(numEvaluators),
+      m_batchSize(std::max<size_t>(batchSize, 1)),
+      m_queueCapacity(std::max<size_t>(queueCapacity, 2))
+   {
+      if (m_numEvaluators == 0) {
+         const unsigned cores = std::thread::hardware_concurrency();
+         m_numEvaluators = cores > m_numProducers + 1 ? cores - m_numProducers - 1 : 1;
+      }
+   }
+
+   unsigned numProducers() const
+   { return m_numProducers; }
+
+   unsigned numEvaluators() const
+   { return m_numEvaluators; }
+
+   size_t batchSize() const
+   { return m_batchSize; }
+
+   size_t queueCapacity() const
+   { return m_queueCapacity; }
+
+   /**
+    * Returns the statistics of the last call to run().
+    */
+   const PipelineStats& stats() const
+   { return m_stats; }
+
+   /**
+    * Evaluates the \c size candidates <tt>generate(i)</tt> and returns the
+    * one with the smallest merit.
+    *
+    * \param generate   Functor with signature <tt>value_type(size_t i)</tt>,
+    *                   called concurrently by the producers.
+    * \param evaluate   Functor with signature <tt>void(const value_type*
+    *                   values, size_t count, Real* merits, const
+    *                   SharedBound& bound)</tt>, called concurrently by the
+    *                   evaluators; it may write infinity for the candidates
+    *                   whose merit is known to exceed \c bound.
+    *
+    * If \c generate or \c evaluate throws, no more candidates are
+    * generated or evaluated, the batches in flight are discarded, and the
+    * first exception is rethrown once all threads have finished.
+    */
+   template <class GENERATE, class EVALUATE>
+   Winner run(size_t size, const GENERATE& generate, const EVALUATE& evaluate);
+
+private:
+   typedef std::chrono::steady_clock Clock;
+
+   struct Batch {
+      size_t first = 0;
+      std::vector<value_type> values;
+   };
+
+   unsigned m_numProducers;
+   unsigned m_numEvaluators;
+   size_t m_batchSize;
+   size_t m_queueCapacity;
+   PipelineStats m_stats;
+
+   static double seconds(Clock::time_point a, Clock::time_point b)
+   { return std::chrono::duration<double>(b - a).count(); }
+
+   /**
+    * Calls <tt>attempt()</tt> until it succeeds or <tt>done()</tt> returns
+    * \c true, spinning briefly before yielding the processor.  Adds the time
+    * spent to \c wait and returns \c true on success.
+    */
+   template <class ATTEMPT, class DONE>
+   static bool waitFor(const ATTEMPT& attempt, const DONE& done, double& wait)
+   {
+      if (attempt())
+         return true;
+      const auto start = Clock::now();
+      bool ok = false;
+      for (unsigned spins = 0; ; spins++) {
+         if (attempt()) {
+            ok = true;
+            break;
+         }
+         if (done()) {
+            // a last attempt, for items pushed before the end was signaled
+            ok = attempt();
+            break;
+         }
+         if (spins >= 64)
+            std::this_thread::yield();
+      }
+      wait += seconds(start, Clock::now());
+      return ok;
+   }
+};
+
+//========================================================================
+// IMPLEMENTATION
+//========================================================================
+
+template <typename VALUE>
+template <class GENERATE, class EVALUATE>
+auto Pipeline<VALUE>::run(size_t size, const GENERATE& generate, const EVALUATE& evaluate) -> Winner
+{
+   const auto start = Clock::now();
+
+   std::vector<Batch> pool(m_queueCapacity);
+   RingBuffer<Batch*> freeBatches(m_queueCapacity);
+   RingBuffer<Batch*> fullBatches(m_queueCapacity);
+   RingBuffer<Winner> winners(m_queueCapacity);
+   for (auto& batch : pool) {
+      batch.values.reserve(m_batchSize);
+      Batch* p = &batch;
+      freeBatches.tryPush(p);
+   }
+
+   BlockCursor cursor(size, m_batchSize);
+   SharedBound bound;
+   std::atomic<unsigned> producersLeft(m_numProducers);
+   std::atomic<unsigned> evaluatorsLeft(m_numEvaluators);
+
+   std::vector<StageStats> producerStats(m_numProducers);
+   std::vector<StageStats> evaluatorStats(m_numEvaluators);
+   StageStats reducerStats;
+   Winner best;
+
+   NTL::GF2EContext context;
+   context.save();
+
+   // the first exception thrown by a stage, rethrown after all threads
+   // have joined; the other stages keep running to drain the queues
+   std::exception_ptr error;
+   std::mutex errorMutex;
+   std::atomic<bool> failed(false);
+   auto fail = [&]() {
+      std::lock_guard<std::mutex> lock(errorMutex);
+      if (not error)
+         error = std::current_exception();
+      failed.store(true, std::memory_order_relaxed);
+      cursor.stop();
+   };
+
+   auto never = []() { return false; };
+
+   auto producer = [&](StageStats& st) {
+      context.restore();
+      size_t first, count;
+      while (cursor.next(first, count)) {
+         Batch* batch = nullptr;
+         waitFor([&]() { return freeBatches.tryPop(batch); }, never, st.waitSeconds);
+         const auto t0 = Clock::now();
+         batch->first = first;
+         batch->values.clear();
+         try {
+            for (size_t i = first; i < first + count; i++)
+               batch->values.push_back(generate(i));
+         }
+         catch (...) {
+            fail();
+            freeBatches.tryPush(batch);
+            break;
+         }
+         st.items += count;
+         st.busySeconds += seconds(t0, Clock::now());
+         // never full: there are as many cells as batches
+         fullBatches.tryPush(batch);
+      }
+      producersLeft.fetch_sub(1, std::memory_order_release);
+   };
+
+   auto evaluator = [&](StageStats& st) {
+      context.restore();
+      std::vector<Real> merits(m_batchSize);
+      auto noMoreBatches = [&]() { return producersLeft.load(std::memory_order_acquire) == 0; };
+      for (;;) {
+         Batch* batch = nullptr;
+         if (not waitFor([&]() { return fullBatches.tryPop(batch); }, noMoreBatches, st.waitSeconds))
+            break;
+         if (failed.load(std::memory_order_relaxed)) {
+            freeBatches.tryPush(batch);
+            continue;
+         }
+         const auto t0 = Clock::now();
+         const size_t count = batch->values.size();
+         try {
+            evaluate(batch->values.data(), count, merits.data(), bound);
+         }
+         catch (...) {
+            fail();
+            freeBatches.tryPush(batch);
+            continue;
+         }
+         Winner w;
+         for (size_t c = 0; c < count; c++) {
+            if (merits[c] < w.merit) {
+               w.merit = merits[c];
+               w.index = batch->first + c;
+               w.value = batch->values[c];
+            }
+         }
+         st.items += count;
+         st.busySeconds += seconds(t0, Clock::now());
+         freeBatches.tryPush(batch);
+         if (w.found()) {
+            // lower the bound right away; the reducer only keeps the winner
+            bound.improve(w.merit);
+            waitFor([&]() { return winners.tryPush(w); }, never, st.waitSeconds);
+         }
+      }
+      evaluatorsLeft.fetch_sub(1, std::memory_order_release);
+   };
+
+   auto reducer = [&]() {
+      auto noMoreWinners = [&]() { return evaluatorsLeft.load(std::memory_order_acquire) == 0; };
+      for (;;) {
+         Winner w;
+         if (not waitFor([&]() { return winners.tryPop(w); }, noMoreWinners, reducerStats.waitSeconds))
+            break;
+         const auto t0 = Clock::now();
+         if (w.beats(best))
+            best = w;
+         reducerStats.items++;
+         reducerStats.busySeconds += seconds(t0, Clock::now());
+      }
+   };
+
+   std::vector<std::thread> threads;
+   for (unsigned i = 0; i < m_numProducers; i++)
+      threads.emplace_back(producer, std::ref(producerStats[i]));
+   for (unsigned i = 0; i < m_numEvaluators; i++)
+      threads.emplace_back(evaluator, std::ref(evaluatorStats[i]));
+   reducer();
+   for (auto& t : threads)
+      t.join();
+   if (error)
+      std::rethrow_exception(error);
+
+   m_stats = PipelineStats();
+   auto merge = [](StageStats& total, const std::vector<StageStats>& stats) {
+      total.threads = stats.size();
+      for (const auto& st : stats) {
+         total.items += st.items;
+         total.busySeconds += st.busySeconds;
+         total.waitSeconds += st.waitSeconds;
+      }
+   };
+   merge(m_stats.producers, producerStats);
+   merge(m_stats.evaluators, evaluatorStats);
+   m_stats.reducer = reducerStats;
+   m_stats.reducer.threads = 1;
+   m_stats.elapsedSeconds = seconds(start, Clock::now());
+   return best;
+}
+
+}}
+
+#endif
@@ -0,0 +1,144 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__PARALLEL__RING_BUFFER_H
+#define POLLATBUILDER__PARALLEL__RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace PolLatBuilder { namespace Parallel {
+
+/**
+ * Bounded lock-free queue for multiple producers and multiple consumers.
+ *
+ * Each cell of the ring carries a sequence number that tells whether it is
+ * ready to be written or read at the current lap, so that a push or a pop
+ * costs a single compare-and-swap on the shared position in the common case
+ * and never blocks: tryPush() fails when the queue is full and tryPop() when
+ * it is empty, and the caller decides how to wait.
+ *
+ * \tparam T   Type of the elements; must be default-constructible and
+ *             movable.
+ */
+template <typename T>
+class RingBuffer {
+public:
+   typedef T value_type;
+   typedef size_t size_type;
+
+   /**
+    * Constructor.
+    *
+    * \param capacity   Minimum capacity; rounded up to a power of 2.
+    */
+   explicit RingBuffer(size_type capacity):
+      m_head(0),
+      m_tail(0)
+   {
+      size_type size = 2;
+      while (size < capacity)
+         size *= 2;
+      m_mask = size - 1;
+      m_cells.reset(new Cell[size]);
+      for (size_type i = 0; i < size; i++)
+         m_cells[i].sequence.store(i, std::memory_order_relaxed);
+   }
+
+   RingBuffer(const RingBuffer&) = delete;
+   RingBuffer& operator=(const RingBuffer&) = delete;
+
+   /**
+    * Returns the maximum number of elements in the queue.
+    */
+   size_type capacity() const
+   { return m_mask + 1; }
+
+   /**
+    * Appends \c x to the queue.  Returns \c false, leaving \c x unchanged,
+    * if the queue is full.
+    */
+   bool tryPush(T& x)
+   {
+      size_type pos = m_head.load(std::memory_order_relaxed);
+      for (;;) {
+         Cell& cell = m_cells[pos & m_mask];
+         const size_type seq = cell.sequence.load(std::memory_order_acquire);
+         const std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+         if (diff == 0) {
+            if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+               cell.value = std::move(x);
+               cell.sequence.store(pos + 1, std::memory_order_release);
+               return true;
+            }
+         }
+         else if (diff < 0)
+            return false;
+         else
+            pos = m_head.load(std::memory_order_relaxed);
+      }
+   }
+
+   /**
+    * Removes the first element of the queue and moves it to \c x.  Returns
+    * \c false if the queue is empty.
+    */
+   bool tryPop(T& x)
+   {
+      size_type pos = m_tail.load(std::memory_order_relaxed);
+      for (;;) {
+         Cell& cell = m_cells[pos & m_mask];
+         const size_type seq = cell.sequence.load(std::memory_order_acquire);
+         const std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos + 1);
+         if (diff == 0) {
+            if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+               x = std::move(cell.value);
+               cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+               return true;
+            }
+         }
+         else if (diff < 0)
+            return false;
+         else
+            pos = m_tail.load(std::memory_order_relaxed);
+      }
+   }
+
+   /**
+    * Returns \c true if the queue looked empty at some point during the
+    * call.
+    */
+   bool empty() const
+   { return m_tail.load(std::memory_order_acquire) >= m_head.load(std::memory_order_acquire); }
+
+private:
+   struct Cell {
+      std::atomic<size_type> sequence;
+      T value;
+   };
+
+   std::unique_ptr<Cell[]> m_cells;
+   size_type m_mask;
+   // producers and consumers update different cache lines
+   alignas(64) std::atomic<size_type> m_head;
+   alignas(64) std::atomic<size_type> m_tail;
+};
+
+}}
+
+#endif
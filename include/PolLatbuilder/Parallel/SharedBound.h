@@ -0,0 +1,81 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__PARALLEL__SHARED_BOUND_H
+#define POLLATBUILDER__PARALLEL__SHARED_BOUND_H
+
+#include "PolLatbuilder/Types.h"
+
+#include <atomic>
+#include <limits>
+
+namespace PolLatBuilder { namespace Parallel {
+
+/**
+ * Best-so-far upper bound on a figure of merit, shared among concurrent
+ * searches.
+ *
+ * The bound only decreases.  Readers see either the current value or a
+ * previous, larger one, which is always safe for pruning.
+ */
+class SharedBound {
+public:
+   /**
+    * Constructor.
+    */
+   explicit SharedBound(Real value = std::numeric_limits<Real>::infinity()):
+      m_value(value)
+   {}
+
+   SharedBound(const SharedBound&) = delete;
+   SharedBound& operator=(const SharedBound&) = delete;
+
+   /**
+    * Returns the current bound.
+    */
+   Real get() const
+   { return m_value.load(std::memory_order_relaxed); }
+
+   /**
+    * Lowers the bound to \c value if it is smaller than the current bound.
+    *
+    * Returns \c true if the bound was lowered.
+    */
+   bool improve(Real value)
+   {
+      Real current = get();
+      while (value < current) {
+         if (m_value.compare_exchange_weak(current, value, std::memory_order_relaxed))
+            return true;
+      }
+      return false;
+   }
+
+   /**
+    * Sets the bound to \c value.
+    *
+    * Must not be called while other threads use the bound.
+    */
+   void reset(Real value = std::numeric_limits<Real>::infinity())
+   { m_value.store(value); }
+
+private:
+   std::atomic<Real> m_value;
+};
+
+}}
+
+#endif
@@ -0,0 +1,292 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__PARALLEL__TOP_K_H
+#define POLLATBUILDER__PARALLEL__TOP_K_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/Parallel/SharedBound.h"
+
+#include <NTL/GF2E.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace PolLatBuilder { namespace Parallel {
+
+/**
+ * Collector of the \f$k\f$ best values found by concurrent threads.
+ *
+ * Each thread offers its values, with their merits and their indices in the
+ * traversal, to its own Local collector, which keeps its \f$k\f$ best values
+ * in a heap.  Once a local heap is full, the merit of its worst value is an
+ * upper bound on the \f$k\f$-th best merit overall, and is published in a
+ * SharedBound without locking.  Values whose merit exceeds that bound are
+ * rejected with a single comparison, and evaluators can use the bound to
+ * abandon candidates early.  The local heaps are merged under a lock when
+ * the threads are done.
+ *
+ * Values are ranked by increasing merit, and ties by increasing index, so
+ * the result does not depend on the scheduling.
+ *
+ * \tparam VALUE  Type of the values.
+ */
+template <typename VALUE>
+class TopK {
+public:
+   typedef VALUE value_type;
+
+   /**
+    * Value collected with its merit and its index in the traversal.
+    */
+   struct Entry {
+      size_t index;
+      value_type value;
+      Real merit;
+
+      /// Returns \c true if \c a ranks before \c b.
+      static bool better(const Entry& a, const Entry& b)
+      { return a.merit < b.merit or (a.merit == b.merit and a.index < b.index); }
+   };
+
+   /**
+    * Collector owned by a single thread.
+    */
+   class Local {
+   public:
+      explicit Local(TopK& parent):
+         m_parent(&parent)
+      { m_heap.reserve(parent.k()); }
+
+      Local(const Local&) = delete;
+      Local& operator=(const Local&) = delete;
+
+      /**
+       * Merges the values collected so far into the parent collector.
+       */
+      ~Local()
+      { merge(); }
+
+      /**
+       * Returns \c false if a value with merit \c merit cannot be among the
+       * \f$k\f$ best ones.
+       */
+      bool admits(Real merit) const
+      { return m_parent->admits(merit); }
+
+      /**
+       * Offers \c value, with merit \c merit and traversal index \c index.
+       * Returns \c true if it is kept.
+       */
+      bool offer(size_t index, const value_type& value, Real merit)
+      {
+         const size_t k = m_parent->k();
+         if (not admits(merit))
+            return false;
+         Entry e{index, value, merit};
+         if (m_heap.size() < k) {
+            m_heap.push_back(std::move(e));
+            std::push_heap(m_heap.begin(), m_heap.end(), &Entry::better);
+         }
+         else if (Entry::better(e, m_heap.front())) {
+            std::pop_heap(m_heap.begin(), m_heap.end(), &Entry::better);
+            m_heap.back() = std::move(e);
+            std::push_heap(m_heap.begin(), m_heap.end(), &Entry::better);
+         }
+         else
+            return false;
+         if (m_heap.size() == k)
+            m_parent->m_bound.improve(m_heap.front().merit);
+         return true;
+      }
+
+      /**
+       * Moves the values collected so far to the parent collector.
+       */
+      void merge()
+      {
+         if (not m_heap.empty())
+            m_parent->merge(m_heap);
+         m_heap.clear();
+      }
+
+   private:
+      TopK* m_parent;
+      // max-heap: the worst value is at the front
+      std::vector<Entry> m_heap;
+   };
+
+   /**
+    * Constructor.
+    *
+    * \param k    Number of values to keep; must be positive.
+    */
+   explicit TopK(size_t k):
+      m_k(k)
+   {
+      if (m_k == 0)
+         throw std::runtime_error("TopK: k must be positive");
+   }
+
+   TopK(const TopK&) = delete;
+   TopK& operator=(const TopK&) = delete;
+
+   /**
+    * Returns the number of values to keep.
+    */
+   size_t k() const
+   { return m_k; }
+
+   /**
+    * Returns an upper bound on the \f$k\f$-th best merit, lowered
+    * concurrently as the threads collect values.
+    */
+   const SharedBound& bound() const
+   { return m_bound; }
+
+   /**
+    * Returns \c false if a value with merit \c merit cannot be among the
+    * \f$k\f$ best ones.
+    */
+   bool admits(Real merit) const
+   { return merit <= m_bound.get(); }
+
+   /**
+    * Returns the best values merged so far, by increasing merit and then by
+    * increasing index.
+    */
+   std::vector<Entry> results() const
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_entries;
+   }
+
+private:
+   size_t m_k;
+   SharedBound m_bound;
+   mutable std::mutex m_mutex;
+   std::vector<Entry> m_entries;
+
+   void merge(std::vector<Entry>& entries)
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      std::sort(entries.begin(), entries.end(), &Entry::better);
+      std::vector<Entry> merged;
+      merged.reserve(std::min(m_k, m_entries.size() + entries.size()));
+      std::merge(
+            std::make_move_iterator(m_entries.begin()), std::make_move_iterator(m_entries.end()),
+            std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()),
+            std::back_inserter(merged), &Entry::better);
+      if (merged.size() > m_k)
+         merged.resize(m_k);
+      m_entries = std::move(merged);
+      if (m_entries.size() == m_k)
+         m_bound.improve(m_entries.back().merit);
+   }
+};
+
+/**
+ * Evaluates all elements of \c seq on \c numThreads threads (all processors
+ * if 0) and returns the \c k best ones, as with TopK::results().
+ *
+ * \c seq can be any sequence, including the non-indexable lattice sequences
+ * LatSeq::CBC, LatSeq::Combiner and LatSeq::Korobov: it is traversed once,
+ * under a lock, in blocks of \c blockSize elements, and the index of an
+ * element is its position in the traversal.  Each thread evaluates the
+ * elements of its blocks with its own copy of \c eval, whose signature must
+ * be <tt>Real(const value_type& x, const SharedBound& bound)</tt>; \c eval
+ * can return infinity as soon as the merit of \c x is known to exceed
+ * \c bound, as CoordUniformCBC::evaluate() does.  The PolyModP context of
+ * the calling thread is installed in all threads.
+ *
+ * If the traversal or an evaluation throws, the other threads stop after
+ * their current block and the first exception is rethrown.
+ */
+template <class SEQ, class EVAL>
+std::vector<typename TopK<typename SEQ::value_type>::Entry> topK(
+      const SEQ& seq,
+      size_t k,
+      const EVAL& eval,
+      unsigned numThreads = 0,
+      size_t blockSize = 64)
+{
+   typedef typename SEQ::value_type value_type;
+
+   TopK<value_type> collector(k);
+   std::mutex mutex;
+   auto it = seq.begin();
+   const auto end = seq.end();
+   size_t next = 0;
+   // the first exception thrown by a thread, rethrown after all threads
+   // have joined
+   std::exception_ptr error;
+
+   NTL::GF2EContext context;
+   context.save();
+
+   auto worker = [&]() {
+      context.restore();
+      EVAL evaluate(eval);
+      typename TopK<value_type>::Local local(collector);
+      std::vector<value_type> block;
+      try {
+         for (;;) {
+            size_t first;
+            block.clear();
+            {
+               std::lock_guard<std::mutex> lock(mutex);
+               first = next;
+               for (; not error and it != end and block.size() < blockSize; ++it)
+                  block.push_back(*it);
+               next += block.size();
+            }
+            if (block.empty())
+               break;
+            for (size_t i = 0; i < block.size(); i++)
+               local.offer(first + i, block[i], evaluate(block[i], collector.bound()));
+         }
+      }
+      catch (...) {
+         std::lock_guard<std::mutex> lock(mutex);
+         if (not error)
+            error = std::current_exception();
+      }
+   };
+
+   if (numThreads == 0)
+      numThreads = std::thread::hardware_concurrency();
+   numThreads = std::max(1u, numThreads);
+   std::vector<std::thread> threads;
+   for (unsigned i = 1; i < numThreads; i++)
+      threads.emplace_back(worker);
+   worker();
+   for (auto& t : threads)
+      t.join();
+   if (error)
+      std::rethrow_exception(error);
+
+   return collector.results();
+}
+
+}}
+
+#endif
@@ -0,0 +1,294 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__POINT_SET_H
+#define POLLATBUILDER__POINT_SET_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/LatDef.h"
+#include "PolLatbuilder/Util.h"
+#include "PolLatbuilder/detail/AlignedAllocator.h"
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+namespace PolLatBuilder {
+
+/**
+ * Structure-of-arrays buffer of points.
+ *
+ * The coordinates of all points are stored coordinate by coordinate: the
+ * \f$j\f$-th coordinate of the \f$i\f$-th point is found at
+ * <tt>coord(j)[i]</tt>.  Each coordinate row starts on a 64-byte boundary and
+ * its length is padded to a multiple of 8 values.
+ */
+class PointBuffer {
+public:
+   typedef std::vector<Real, detail::AlignedAllocator<Real>> Storage;
+
+   /**
+    * Constructor.
+    *
+    * \param dimension     Number of coordinates.
+    * \param numPoints     Number of points.
+    */
+   PointBuffer(Dimension dimension = 0, Modulus numPoints = 0)
+   { resize(dimension, numPoints); }
+
+   /**
+    * Changes the size of the buffer.  The contents are not preserved.
+    */
+   void resize(Dimension dimension, Modulus numPoints)
+   {
+      m_dimension = dimension;
+      m_numPoints = numPoints;
+      m_stride = (numPoints + 7) / 8 * 8;
+      m_data.resize(m_dimension * m_stride);
+   }
+
+   /**
+    * Returns the number of coordinates.
+    */
+   Dimension dimension() const
+   { return m_dimension; }
+
+   /**
+    * Returns the number of points.
+    */
+   Modulus numPoints() const
+   { return m_numPoints; }
+
+   /**
+    * Returns the distance between two consecutive coordinate rows.
+    */
+   size_t stride() const
+   { return m_stride; }
+
+   /**
+    * Returns a pointer to the values of the \c j-th coordinate of all points.
+    */
+   Real* coord(Dimension j)
+   { return m_data.data() + j * m_stride; }
+
+   /// \copydoc coord()
+   const Real* coord(Dimension j) const
+   { return m_data.data() + j * m_stride; }
+
+   /**
+    * Returns the \c j-th coordinate of the \c i-th point.
+    */
+   Real operator()(Modulus i, Dimension j) const
+   { return coord(j)[i]; }
+
+private:
+   Dimension m_dimension;
+   Modulus m_numPoints;
+   size_t m_stride;
+   Storage m_data;
+};
+
+/**
+ * Point set of a rank-1 polynomial lattice.
+ *
+ * For a modulus \f$P\f$ of degree \f$m\f$ and a generating vector
+ * \f$(g_1, \dots, g_s)\f$, the points are
+ * \f$\boldsymbol x_k = (\phi(k g_1 / P), \dots, \phi(k g_s / P))\f$ for all
+ * polynomials \f$k\f$ of degree smaller than \f$m\f$, where \f$\phi\f$ maps
+ * the Laurent series \f$\sum_l u_l x^{-l}\f$ to \f$\sum_l u_l 2^{-l}\f$,
+ * truncated to a fixed number of digits.
+ *
+ * The expansion of \f$k g_j / P\f$ is linear in the coefficients of \f$k\f$,
+ * so the points are generated in Gray-code order: the \f$i\f$-th point
+ * corresponds to the polynomial \f$k\f$ whose integer representation (see
+ * intToPoly()) is grayCode(i), and the digits of each coordinate are updated
+ * with a single XOR from one point to the next.
+ *
+ * \tparam LAT  Type of lattice.
+ */
+template <LatType LAT>
+class PointSet {
+public:
+   /**
+    * Constructor.
+    *
+    * \param lat        Lattice definition.
+    * \param precision  Number of binary digits of each coordinate; at most 63.
+    *                   If 0, the degree of the modulus is used.
+    */
+   PointSet(const LatDef<LAT>& lat, unsigned precision = 0):
+      m_degree(deg(lat.sizeParam().polynomial())),
+      m_precision(precision ? precision : m_degree),
+      m_dimension(lat.dimension())
+   {
+      if (m_degree < 1 or m_degree > 63)
+         throw std::runtime_error("PointSet: modulus degree must be in 1..63");
+      if (m_precision > 63)
+         throw std::runtime_error("PointSet: precision must be at most 63");
+      m_scale = 1.0 / Real(uint64_t(1) << m_precision);
+
+      const Modulus P = polyToInt(lat.sizeParam().polynomial());
+      m_columns.reserve(m_dimension * m_degree);
+      for (const auto& g : lat.gen()) {
+         const auto cols = laurentColumns(polyToInt(rep(g)), P, m_precision, m_degree);
+         m_columns.insert(m_columns.end(), cols.begin(), cols.end());
+      }
+   }
+
+   /**
+    * Returns the dimension of the point set.
+    */
+   Dimension dimension() const
+   { return m_dimension; }
+
+   /**
+    * Returns the degree of the modulus.
+    */
+   unsigned degree() const
+   { return m_degree; }
+
+   /**
+    * Returns the number of binary digits of each coordinate.
+    */
+   unsigned precision() const
+   { return m_precision; }
+
+   /**
+    * Returns the number of points.
+    */
+   Modulus numPoints() const
+   { return Modulus(1) << m_degree; }
+
+   /**
+    * Returns a pointer to the \f$m\f$ packed digit columns of coordinate \c j.
+    *
+    * The \f$s\f$-th column holds the digits of \f$x^s g_j / P\f$, with the
+    * first digit as the most significant of precision() bits.
+    */
+   const uint64_t* columns(Dimension j) const
+   { return m_columns.data() + j * m_degree; }
+
+   /**
+    * Returns the Gray code of \c i.
+    */
+   static Modulus grayCode(Modulus i)
+   { return i ^ (i >> 1); }
+
+   /**
+    * Returns the packed digits of the \c j-th coordinate of the point
+    * associated to the polynomial \c k.
+    *
+    * This costs \f$O(m)\f$ bit operations and does not depend on other
+    * points.
+    */
+   uint64_t digits(Modulus k, Dimension j) const
+   {
+      const uint64_t* col = columns(j);
+      uint64_t x = 0;
+      for (; k; k &= k - 1)
+         x ^= col[trailingZeros(k)];
+      return x;
+   }
+
+   /**
+    * Returns the value of a coordinate from its packed digits.
+    */
+   Real toReal(uint64_t digits) const
+   { return Real(int64_t(digits)) * m_scale; }
+
+   /**
+    * Writes the \c j-th coordinate of the points of Gray-code indices
+    * \c first to <tt>first + count - 1</tt> to \c out.
+    *
+    * \param state     Packed digits of the coordinate of the point of index
+    *                  \c first, as returned by
+    *                  <tt>digits(grayCode(first), j)</tt>.
+    *                  On return, it contains the digits of the last point
+    *                  written.
+    *
+    * Throws \c std::runtime_error if the points are not all in the point set.
+    */
+   void generate(Dimension j, Modulus first, Modulus count, uint64_t& state, Real* out) const
+   {
+      checkRange(first, count);
+      if (count == 0)
+         return;
+      const uint64_t* col = columns(j);
+      uint64_t x = state;
+      out[0] = toReal(x);
+      for (Modulus t = 1; t < count; t++) {
+         x ^= col[trailingZeros(first + t)];
+         out[t] = toReal(x);
+      }
+      state = x;
+   }
+
+   /**
+    * Writes the points of Gray-code indices \c first to
+    * <tt>first + count - 1</tt> into \c buf.
+    *
+    * Starting at an arbitrary index costs \f$O(m)\f$ bit operations per
+    * coordinate.  \c buf is resized as needed.
+    *
+    * Throws \c std::runtime_error if the points are not all in the point set.
+    */
+   void generate(Modulus first, Modulus count, PointBuffer& buf) const
+   {
+      checkRange(first, count);
+      if (buf.dimension() != m_dimension or buf.numPoints() != count)
+         buf.resize(m_dimension, count);
+      const Modulus k = grayCode(first);
+      for (Dimension j = 0; j < m_dimension; j++) {
+         uint64_t state = digits(k, j);
+         generate(j, first, count, state, buf.coord(j));
+      }
+   }
+
+   /**
+    * Writes all points into \c buf, in Gray-code order.
+    *
+    * \c buf is resized as needed.
+    */
+   void generate(PointBuffer& buf) const
+   { generate(0, numPoints(), buf); }
+
+   /**
+    * Returns a buffer containing all points, in Gray-code order.
+    */
+   PointBuffer points() const
+   {
+      PointBuffer buf;
+      generate(buf);
+      return buf;
+   }
+
+private:
+   unsigned m_degree;
+   unsigned m_precision;
+   Dimension m_dimension;
+   Real m_scale;
+   std::vector<uint64_t> m_columns;
+
+   void checkRange(Modulus first, Modulus count) const
+   {
+      if (first > numPoints() or count > numPoints() - first)
+         throw std::runtime_error("PointSet: point indices out of range");
+   }
+};
+
+}
+
+#endif
@@ -0,0 +1,163 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__POINT_STREAM_H
+#define POLLATBUILDER__POINT_STREAM_H
+
+#include "PolLatbuilder/PointSet.h"
+#include "PolLatbuilder/Parallel/BlockCursor.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace PolLatBuilder {
+
+/**
+ * Stream of points of a polynomial lattice, read in fixed-size chunks.
+ *
+ * The stream visits the points of a PointSet in Gray-code order, over the
+ * index range \f$[first, last)\f$.  It can be repositioned at any index with
+ * seek() in \f$O(m)\f$ bit operations per coordinate, without generating the
+ * preceding points, so that concurrent consumers can each stream a disjoint
+ * block of the same point set.  Blocks can be distributed among threads with
+ * a Parallel::BlockCursor:
+ * \code
+ * Parallel::BlockCursor cursor(pointSet.numPoints(), 1 << 16);
+ * // in each thread:
+ * PointStream<LatType::ORDINARY> stream(pointSet, 1024);
+ * PointBuffer chunk;
+ * size_t first, count;
+ * while (cursor.next(first, count)) {
+ *    stream.setRange(first, first + count);
+ *    while (Modulus n = stream.read(chunk))
+ *       consume(chunk, n);
+ * }
+ * \endcode
+ *
+ * \tparam LAT  Type of lattice.
+ */
+template <LatType LAT>
+class PointStream {
+public:
+   /**
+    * Constructor.
+    *
+    * \param pointSet   Point set; must outlive the stream.
+    * \param chunkSize  Maximum number of points returned by each call to
+    *                   read().
+    */
+   PointStream(const PointSet<LAT>& pointSet, Modulus chunkSize):
+      m_pointSet(&pointSet),
+      m_chunkSize(std::max<Modulus>(chunkSize, 1)),
+      m_state(pointSet.dimension())
+   { setRange(0, pointSet.numPoints()); }
+
+   /**
+    * Returns the point set.
+    */
+   const PointSet<LAT>& pointSet() const
+   { return *m_pointSet; }
+
+   /**
+    * Returns the maximum number of points returned by read().
+    */
+   Modulus chunkSize() const
+   { return m_chunkSize; }
+
+   /**
+    * Restricts the stream to the Gray-code indices in \f$[first, last)\f$ and
+    * moves to \c first.
+    */
+   void setRange(Modulus first, Modulus last)
+   {
+      m_last = std::min(last, m_pointSet->numPoints());
+      seek(first);
+   }
+
+   /**
+    * Moves the stream to the point of Gray-code index \c i.
+    */
+   void seek(Modulus i)
+   {
+      m_position = i;
+      if (m_position >= m_last)
+         return;
+      const Modulus k = PointSet<LAT>::grayCode(i);
+      for (Dimension j = 0; j < m_state.size(); j++)
+         m_state[j] = m_pointSet->digits(k, j);
+   }
+
+   /**
+    * Returns the Gray-code index of the next point to be read.
+    */
+   Modulus position() const
+   { return m_position; }
+
+   /**
+    * Returns \c true if all points in the range have been read.
+    */
+   bool atEnd() const
+   { return m_position >= m_last; }
+
+   /**
+    * Writes the next chunk of points into \c buf and advances the stream.
+    *
+    * The <tt>chunkSize()</tt> first columns of \c buf are used; \c buf is
+    * resized to that size if needed.  Returns the number of points written,
+    * which is smaller than chunkSize() only at the end of the range, and zero
+    * past it.
+    */
+   Modulus read(PointBuffer& buf)
+   {
+      if (buf.dimension() != m_state.size() or buf.numPoints() != m_chunkSize)
+         buf.resize(m_state.size(), m_chunkSize);
+      return read(buf.coord(0), buf.stride());
+   }
+
+   /**
+    * Writes the next chunk of points into a caller-owned structure-of-arrays
+    * buffer and advances the stream.
+    *
+    * The \f$j\f$-th coordinate of the \f$t\f$-th point of the chunk is
+    * written to <tt>out[j * stride + t]</tt>.
+    * Returns the number of points written.
+    */
+   Modulus read(Real* out, size_t stride)
+   {
+      if (atEnd())
+         return 0;
+      const Modulus count = std::min(m_chunkSize, m_last - m_position);
+      for (Dimension j = 0; j < m_state.size(); j++) {
+         m_pointSet->generate(j, m_position, count, m_state[j], out + j * stride);
+         // step to the first point of the next chunk
+         if (m_position + count < m_last)
+            m_state[j] ^= m_pointSet->columns(j)[trailingZeros(m_position + count)];
+      }
+      m_position += count;
+      return count;
+   }
+
+private:
+   const PointSet<LAT>* m_pointSet;
+   Modulus m_chunkSize;
+   Modulus m_position;
+   Modulus m_last;
+   std::vector<uint64_t> m_state;
+};
+
+}
+
+#endif
@@ -55,6 +55,46 @@ public:
    }
 };
 
+/**
+ * Iterator incrementing policy that traverses unidimensional sequences
+ * sequentially, like CartesianProduct, but keeps the first component at the
+ * first value of its sequence.
+ *
+ * Multiplying a generating vector by a unit modulo \f$P\f$ does not change
+ * the lattice point set.  If the first sequence contains only units and
+ * starts with 1, as GenSeq::CoprimePolynomials without compression does, and
+ * the other sequences are closed under multiplication by units, the compound
+ * sequence thus contains exactly one representative of each class of
+ * equivalent generating vectors, and is \f$\varphi(P)\f$ times shorter than
+ * the full Cartesian product.
+ */
+template <typename DERIVED>
+class CanonicalCartesianProduct {
+private:
+   DERIVED& derived() { return static_cast<DERIVED&>(*this); }
+public:
+   bool increment()
+   {
+      // iterate backwards through all components but the first
+      auto out = derived().m_value.rbegin();
+      auto seq = derived().m_seq->seqs().rbegin();
+      auto val = derived().m_its.rbegin();
+      const auto last = derived().m_its.rend() - 1;
+      while (val != last) {
+         if (++*val == seq->end()) {
+            *val = seq->begin();
+            *out = **val;
+         }
+         else {
+            *out = **val;
+            return false;
+         }
+         ++out; ++seq; ++val;
+      }
+      return true;
+   }
+};
+
 /**
  * Iterator incrementing policy that traverses unidimensional sequences in
  * parallel.
@@ -90,6 +130,9 @@ public:
  *                   If set to CartesianProduct, the output values of the
  *                   compound sequence are all values from the Cartesian product
  *                   of the input unidimensional sequences.
+ *                   If set to CanonicalCartesianProduct, the first
+ *                   component is fixed and the other ones take all values
+ *                   from the Cartesian product of their sequences.
  *                   If set to Zip, the \f$i\f$-th output value is a
  *                   vector whose \f$j\f$-th component consist of the \f$i\f$-th
  *                   value of the \f$j\f$-th input sequence.
@@ -0,0 +1,99 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__T_VALUE_H
+#define POLLATBUILDER__T_VALUE_H
+
+/** \file
+ * Exact computation of the t-value of digital nets in base 2.
+ *
+ * The digital net with \f$m\f$-column generating matrices
+ * \f$C_1, \dots, C_s\f$ is a \f$(t,m,s)\f$-net where \f$t = m - \rho\f$ and
+ * \f$\rho\f$, the strength, is the largest \f$d\f$ such that, for every
+ * composition \f$d_1 + \dots + d_s = d\f$, the first \f$d_j\f$ rows of the
+ * matrices \f$C_j\f$ are linearly independent.
+ *
+ * The compositions are enumerated depth-first, coordinate by coordinate,
+ * while the selected rows are kept in an echelon basis: moving from one
+ * composition to the next only adds or removes the rows that differ, so
+ * each composition costs a single incremental rank update on average, and
+ * a dependent prefix discards all compositions extending it.  The work is
+ * split among threads across compositions and across projections.
+ */
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/GeneratingMatrix.h"
+
+#include <vector>
+
+namespace PolLatBuilder {
+
+/**
+ * Returns the t-value of the projection of the digital net with generating
+ * matrices \c mats on the coordinates \c coords.
+ *
+ * \param mats          Generating matrices, all with the same number \f$m\f$
+ *                      of columns and at least \f$m\f$ rows.
+ * \param coords        Coordinates of the projection, as indices in \c mats.
+ * \param numThreads    Number of threads used to enumerate the compositions;
+ *                      if 0, the number of hardware threads is used.
+ * \param lowerBound    Known lower bound on the t-value, for instance the
+ *                      largest t-value of a lower-order projection.
+ */
+unsigned tValue(
+      const std::vector<GeneratingMatrix>& mats,
+      const std::vector<Dimension>& coords,
+      unsigned numThreads = 0,
+      unsigned lowerBound = 0);
+
+/**
+ * Returns the t-value of the digital net with generating matrices \c mats.
+ *
+ * \copydetails tValue(const std::vector<GeneratingMatrix>&, const std::vector<Dimension>&, unsigned, unsigned)
+ */
+unsigned tValue(
+      const std::vector<GeneratingMatrix>& mats,
+      unsigned numThreads = 0,
+      unsigned lowerBound = 0);
+
+/**
+ * t-value of a projection.
+ */
+struct ProjectionTValue {
+   std::vector<Dimension> coordinates;
+   unsigned tValue;
+};
+
+/**
+ * Returns the t-values of all projections of orders 1 to \c maxOrder of the
+ * digital net with generating matrices \c mats.
+ *
+ * Projections are processed by increasing order, in lexicographic order of
+ * their coordinates within each order, and distributed among \c numThreads
+ * threads (all hardware threads if 0).  The largest t-value of the
+ * lower-order subprojections of each projection is used as a lower bound.
+ *
+ * Throws \c std::runtime_error if the matrices do not all have the same
+ * number of columns.
+ */
+std::vector<ProjectionTValue> projectionTValues(
+      const std::vector<GeneratingMatrix>& mats,
+      Dimension maxOrder,
+      unsigned numThreads = 0);
+
+}
+
+#endif
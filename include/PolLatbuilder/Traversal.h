@@ -130,6 +130,51 @@ protected:
    size_type m_size;
 };
 
+/**
+ * Stratified traversal type.
+ *
+ * Visits the elements in the bit-reversed (van der Corput) order of their
+ * indices, so that the first elements visited are spread over the whole
+ * sequence (see IndexedIterator::Stratified).  Searches truncated with
+ * resize() or stopped early thus sample the sequence evenly, unlike with
+ * Forward, and without the clusters and repetitions of Random.
+ */
+class Stratified {
+public:
+   /**
+    * Size type.
+    */
+   typedef size_t size_type;
+
+   static std::string name()
+   { return "stratified traversal"; }
+
+   /**
+    * Constructor.
+    *
+    * \param size       Traversal size: number of sequence values to be
+    *                   visited.
+    */
+   Stratified(size_type size = std::numeric_limits<size_type>::max()):
+      m_size(size)
+   {}
+
+   /**
+    * Returns the traversal size.
+    */
+   size_t size() const
+   { return m_size; }
+
+   /**
+    * Changes the traversal size to \c size.
+    */
+   void resize(size_type size)
+   { m_size = size; }
+
+protected:
+   size_type m_size;
+};
+
 /**
  * Traversal policy.  Must be specialized.
  */
@@ -218,6 +263,45 @@ private:
 
 };
 
+/**
+ * Traversal policy specialization for Stratified traversal.
+ */
+template <typename SEQ>
+class Policy<SEQ, Stratified> : public Stratified {
+public:
+   /**
+    * Constructor.
+    */
+   explicit Policy(Stratified trav):
+      Stratified(std::move(trav))
+   {}
+
+   /**
+    * Immutable iterator type.
+    */
+   typedef IndexedIterator::Stratified<SEQ> const_iterator;
+
+   /**
+    * Returns an iterator pointing to the first element visited in \c seq.
+    */
+   const_iterator begin() const
+   { return const_iterator(seq()); }
+
+   /**
+    * Returns an iterator pointing past the last element visited in \c seq.
+    */
+   const_iterator end() const
+   {
+      return const_iterator(seq(), std::min(m_size, (size_type)seq().size()),
+            typename const_iterator::end_tag{});
+   }
+
+private:
+   const SEQ& seq() const
+   { return static_cast<const SEQ&>(*this); }
+
+};
+
 }}
 
 #endif
@@ -0,0 +1,192 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__TRAVERSAL_SCHEDULE_H
+#define POLLATBUILDER__TRAVERSAL_SCHEDULE_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/Traversal.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iosfwd>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace PolLatBuilder {
+
+/**
+ * Traversal of the candidate generators of one coordinate of a CBC
+ * construction.
+ */
+struct CoordinateTraversal {
+   enum class Kind {
+      /// All candidates, in order (Traversal::Forward).
+      FORWARD,
+      /// \c size candidates drawn with replacement (Traversal::Random).
+      RANDOM,
+      /// The first \c size candidates in bit-reversed order
+      /// (Traversal::Stratified).
+      STRATIFIED
+   };
+
+   Kind kind = Kind::FORWARD;
+   /// Number of candidates; ignored for FORWARD.
+   size_t size = 0;
+
+   static CoordinateTraversal forward()
+   { return CoordinateTraversal{Kind::FORWARD, 0}; }
+
+   static CoordinateTraversal random(size_t size)
+   { return CoordinateTraversal{Kind::RANDOM, size}; }
+
+   static CoordinateTraversal stratified(size_t size)
+   { return CoordinateTraversal{Kind::STRATIFIED, size}; }
+
+   /**
+    * Returns the number of candidates evaluated out of \c numCandidates.
+    */
+   size_t cost(size_t numCandidates) const
+   {
+      if (kind == Kind::FORWARD)
+         return numCandidates;
+      return kind == Kind::STRATIFIED ? std::min(size, numCandidates) : size;
+   }
+};
+
+std::ostream& operator<<(std::ostream& os, const CoordinateTraversal& trav);
+
+/**
+ * Traversals of the candidate generators of the successive coordinates of a
+ * CBC construction.
+ *
+ * The first coordinates usually have the largest weights and determine most
+ * of the merit, while good generators for the last ones are plentiful; a
+ * schedule can thus search the first coordinates exhaustively and only a
+ * subset of the candidates for the others.  The coordinates beyond those
+ * given use the last traversal of the schedule.
+ *
+ * The schedule is applied with cbcSchedule().
+ */
+class TraversalSchedule {
+public:
+   /**
+    * Constructor for the schedule that searches all coordinates
+    * exhaustively.
+    */
+   TraversalSchedule():
+      m_travs(1, CoordinateTraversal::forward())
+   {}
+
+   /**
+    * Constructor.
+    *
+    * \param travs   Traversals of the coordinates \f$0, 1, \dots\f$; must not
+    *                be empty.
+    */
+   explicit TraversalSchedule(std::vector<CoordinateTraversal> travs):
+      m_travs(std::move(travs))
+   {
+      if (m_travs.empty())
+         throw std::runtime_error("TraversalSchedule: empty schedule");
+   }
+
+   /**
+    * Returns the schedule with the smallest number of evaluations not
+    * exceeding \c budget in total, for \c dimension coordinates with
+    * \c numCandidates candidate generators each, that searches as many of
+    * the first coordinates as possible exhaustively.
+    *
+    * The coordinates that follow the exhaustive ones share the rest of the
+    * budget evenly, with traversals of type \c later, and at least
+    * \c minSize candidates each: if the budget is too small for that, it is
+    * exceeded.
+    */
+   static TraversalSchedule budgeted(
+         Dimension dimension,
+         size_t numCandidates,
+         uint64_t budget,
+         CoordinateTraversal::Kind later = CoordinateTraversal::Kind::RANDOM,
+         size_t minSize = 64);
+
+   /**
+    * Returns the traversal of coordinate \c j.
+    */
+   const CoordinateTraversal& operator[](Dimension j) const
+   { return j < m_travs.size() ? m_travs[j] : m_travs.back(); }
+
+   /**
+    * Returns the traversals given to the constructor.
+    */
+   const std::vector<CoordinateTraversal>& traversals() const
+   { return m_travs; }
+
+   /**
+    * Returns the total number of candidates evaluated for \c dimension
+    * coordinates with \c numCandidates candidates each.
+    */
+   uint64_t cost(Dimension dimension, size_t numCandidates) const;
+
+private:
+   std::vector<CoordinateTraversal> m_travs;
+};
+
+std::ostream& operator<<(std::ostream& os, const TraversalSchedule& schedule);
+
+/**
+ * Extends the base lattice of the CBC evaluator \c eval up to dimension
+ * \c dimension, selecting each coordinate \f$j\f$ with
+ * <tt>eval.selectBest()</tt> among the candidates of \c genSeq visited with
+ * the traversal <tt>schedule[j]</tt>, and returns the merit of the
+ * resulting lattice.
+ *
+ * \c genSeq must support rebind() to Traversal::Forward,
+ * Traversal::Random<std::mt19937_64> and Traversal::Stratified, as
+ * GenSeq::CoprimePolynomials does.  The random generator of coordinate
+ * \f$j\f$ is seeded with \c seed plus \f$j\f$, so that the result does not
+ * depend on the traversals of the other coordinates.
+ */
+template <class EVAL, class GENSEQ>
+Real cbcSchedule(
+      EVAL& eval,
+      const GENSEQ& genSeq,
+      const TraversalSchedule& schedule,
+      Dimension dimension,
+      uint64_t seed = 0)
+{
+   for (Dimension j = eval.baseLat().dimension(); j < dimension; j++) {
+      const auto& trav = schedule[j];
+      switch (trav.kind) {
+      case CoordinateTraversal::Kind::FORWARD:
+         eval.selectBest(genSeq.rebind(Traversal::Forward()));
+         break;
+      case CoordinateTraversal::Kind::RANDOM:
+         eval.selectBest(genSeq.rebind(Traversal::Random<std::mt19937_64>(trav.size, std::mt19937_64(seed + j))));
+         break;
+      case CoordinateTraversal::Kind::STRATIFIED:
+         eval.selectBest(genSeq.rebind(Traversal::Stratified(trav.size)));
+         break;
+      }
+   }
+   return eval.baseMerit();
+}
+
+}
+
+#endif
@@ -24,8 +24,10 @@
 
 #include "PolLatbuilder/Types.h"
 
+#include <cmath>
 #include <map>
 #include <vector>
+#include <cstdint>
 
 //================================================================================
 
@@ -64,6 +66,122 @@ T intPow(T base, unsigned long exponent)
  */
 Poly intToPoly(Modulus x);
 
+/**
+ * convert polynomial to Integer
+ *
+ * This is the inverse of intToPoly().
+ * Note that the degree of the polynomial must be <64
+ */
+Modulus polyToInt(const Poly& P);
+
+/**
+ * Number of trailing zero bits of \c x.
+ *
+ * \c x must be nonzero.
+ */
+inline unsigned trailingZeros(uint64_t x)
+{
+#if defined(__GNUC__)
+   return __builtin_ctzll(x);
+#else
+   unsigned n = 0;
+   while (!(x & 1)) { x >>= 1; n++; }
+   return n;
+#endif
+}
+
+/**
+ * Number of leading zero bits of \c x, as a 64-bit word.
+ *
+ * Returns 64 if \c x is zero.
+ */
+inline unsigned leadingZeros(uint64_t x)
+{
+#if defined(__GNUC__)
+   return x ? __builtin_clzll(x) : 64;
+#else
+   unsigned n = 64;
+   while (x) { x >>= 1; n--; }
+   return n;
+#endif
+}
+
+/**
+ * Returns the \c numBits least significant bits of \c x in reverse order.
+ *
+ * \c numBits must be at most 64.
+ */
+inline uint64_t reverseBits(uint64_t x, unsigned numBits)
+{
+   if (numBits == 0)
+      return 0;
+   // swap adjacent bits, pairs, nibbles, bytes, and so on
+   x = ((x >> 1) & 0x5555555555555555ull) | ((x & 0x5555555555555555ull) << 1);
+   x = ((x >> 2) & 0x3333333333333333ull) | ((x & 0x3333333333333333ull) << 2);
+   x = ((x >> 4) & 0x0f0f0f0f0f0f0f0full) | ((x & 0x0f0f0f0f0f0f0f0full) << 4);
+#if defined(__GNUC__)
+   x = __builtin_bswap64(x);
+#else
+   x = ((x >> 8) & 0x00ff00ff00ff00ffull) | ((x & 0x00ff00ff00ff00ffull) << 8);
+   x = ((x >> 16) & 0x0000ffff0000ffffull) | ((x & 0x0000ffff0000ffffull) << 16);
+   x = (x >> 32) | (x << 32);
+#endif
+   return x >> (64 - numBits);
+}
+
+/**
+ * Sum of floating-point values with Neumaier's variant of Kahan summation.
+ *
+ * The rounding error of each addition is accumulated separately and added to
+ * the sum by value(), so that the error of the result does not grow with the
+ * number of terms.
+ */
+class CompensatedSum {
+public:
+   CompensatedSum(Real value = 0.0):
+      m_sum(value),
+      m_compensation(0.0)
+   {}
+
+   CompensatedSum& operator+=(Real x)
+   {
+      const Real t = m_sum + x;
+      if (std::abs(m_sum) >= std::abs(x))
+         m_compensation += (m_sum - t) + x;
+      else
+         m_compensation += (x - t) + m_sum;
+      m_sum = t;
+      return *this;
+   }
+
+   /**
+    * Returns the compensated sum.
+    */
+   Real value() const
+   { return m_sum + m_compensation; }
+
+private:
+   Real m_sum;
+   Real m_compensation;
+};
+
+/**
+ * Laurent series expansion of \f$g(x)/P(x)\f$.
+ *
+ * Computes the coefficients \f$u_1, u_2, \dots\f$ of the expansion
+ * \f$g(x)/P(x) = \sum_{l \geq 1} u_l x^{-l}\f$, where \c g and \c P are
+ * given in the integer representation of intToPoly() and \f$\deg(g) <
+ * \deg(P)\f$, by repeated shift-and-reduce on machine words.
+ *
+ * The result contains \c numCols packed columns of the Hankel matrix
+ * \f$(u_{r+s+1})\f$ with \c numRows rows: the \f$s\f$-th word holds
+ * \f$u_{s+1}, \dots, u_{s+numRows}\f$ from its most significant bit (of
+ * \c numRows bits) down to its least significant bit.
+ *
+ * The degree of \c P must be in 1..63 and \c numRows in 1..64.
+ */
+std::vector<uint64_t> laurentColumns(Modulus g, Modulus P, unsigned numRows, unsigned numCols);
+
 /**
  * Modular exponentiation.
  *
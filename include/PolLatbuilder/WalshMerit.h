@@ -0,0 +1,130 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__WALSH_MERIT_H
+#define POLLATBUILDER__WALSH_MERIT_H
+
+#include "PolLatbuilder/Types.h"
+#include "PolLatbuilder/LatDef.h"
+#include "PolLatbuilder/Weights.h"
+#include "PolLatbuilder/GeneratingMatrix.h"
+#include "PolLatbuilder/Kernel/NuTable.h"
+
+#include <vector>
+
+namespace PolLatBuilder {
+
+/**
+ * Evaluation of Walsh figures of merit of polynomial lattice rules with the
+ * fast Walsh-Hadamard transform (see fwht()).
+ *
+ * For a kernel \f$\omega(x) = \sum_h \hat\omega(h) (-1)^{h \cdot x}\f$ on
+ * \f$m\f$-digit points and product weights \f$\gamma_j\f$, the figure of merit
+ * of a rule with \f$n = 2^m\f$ points is
+ * \f[
+ *    \frac1n \sum_{k} \prod_{j} \bigl(1 + \gamma_j \omega(C_j k)\bigr) - 1
+ *    = \sum_{\boldsymbol h \in \mathcal D \setminus \{\boldsymbol 0\}}
+ *      \prod_{j} \rho_j(h_j),
+ * \f]
+ * where \f$C_j\f$ is the generating matrix of coordinate \f$j\f$,
+ * \f$\rho_j(h) = [h = 0] + \gamma_j \hat\omega(h)\f$ and \f$\mathcal D\f$ is
+ * the dual net, the set of \f$\boldsymbol h\f$ such that \f$\sum_j C_j^T h_j =
+ * 0\f$.  For each coordinate, the indicator vector \f$R_j(y) = \sum_{h : C_j^T
+ * h = y} \rho_j(h)\f$ is built with one XOR per entry and its transform
+ * \f$\hat R_j(k) = 1 + \gamma_j \omega(C_j k)\f$ is obtained with a fast
+ * Walsh-Hadamard transform; the merit is the mean of the product of the
+ * transforms, minus one.
+ *
+ * The Walsh coefficients \f$\hat\omega(h)\f$ are arbitrary, so that figures of
+ * merit defined on the dual net, without a closed form for \f$\omega\f$, are
+ * evaluated at the same \f$O(s n \log n)\f$ cost.  The \f$j\f$-th bit (from
+ * the most significant of \f$m\f$ bits) of \f$h\f$ is paired with the
+ * \f$j\f$-th digit of \f$x\f$, as in the packed digits of PointSet.
+ */
+class WalshMerit {
+public:
+   /**
+    * Constructor.
+    *
+    * \param numDigits     Degree \f$m\f$ of the modulus of the lattices; at
+    *                      most 30.
+    * \param coefficients  Walsh coefficients \f$\hat\omega(h)\f$ for
+    *                      \f$0 \leq h < 2^m\f$.
+    */
+   WalshMerit(unsigned numDigits, RealVector coefficients);
+
+   /**
+    * Constructor for the kernel tabulated in \c table.
+    *
+    * The Walsh coefficients are obtained from the values of the kernel on all
+    * \f$m\f$-digit points with a single transform.
+    */
+   explicit WalshMerit(const Kernel::NuTable& table);
+
+   /**
+    * Returns the degree of the modulus of the lattices.
+    */
+   unsigned numDigits() const
+   { return m_numDigits; }
+
+   /**
+    * Returns the number of points of the lattices.
+    */
+   Modulus numPoints() const
+   { return Modulus(1) << m_numDigits; }
+
+   /**
+    * Returns the Walsh coefficients of the kernel.
+    */
+   const RealVector& coefficients() const
+   { return m_coefficients; }
+
+   /**
+    * Returns the figure of merit of \c lat for the weights \c weights.
+    */
+   Real operator()(const LatDef<LatType::ORDINARY>& lat, const ProductWeights& weights) const;
+
+   /**
+    * Returns the figures of merit of all lattices in \c lats, evaluated
+    * concurrently on \c numThreads threads (all available cores if 0).
+    *
+    * Throws \c std::runtime_error, before starting the threads, if a lattice
+    * does not have a modulus of degree numDigits().
+    */
+   RealVector operator()(
+         const std::vector<LatDef<LatType::ORDINARY>>& lats,
+         const ProductWeights& weights,
+         unsigned numThreads = 0) const;
+
+   /**
+    * Writes the indicator vector \f$R(y)\f$ of the coordinate with generating
+    * matrix \c mat and weight \c weight to the numPoints() values of \c out.
+    *
+    * Entry \f$y\f$ corresponds to the polynomial \f$k\f$ whose integer
+    * representation is \f$y\f$ after transformation.
+    */
+   void indicatorVector(const GeneratingMatrix& mat, Real weight, Real* out) const;
+
+private:
+   unsigned m_numDigits;
+   RealVector m_coefficients;
+
+   Real evaluate(const LatDef<LatType::ORDINARY>& lat, const ProductWeights& weights, RealVector& prod, RealVector& work) const;
+};
+
+}
+
+#endif
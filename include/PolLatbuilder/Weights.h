@@ -0,0 +1,246 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__WEIGHTS_H
+#define POLLATBUILDER__WEIGHTS_H
+
+/** \file
+ * Projection weights \f$\gamma_{\mathfrak u}\f$ of weighted figures of merit.
+ *
+ * Coordinates are numbered from 0.
+ */
+
+#include "PolLatbuilder/Types.h"
+
+#include <map>
+#include <cstdint>
+#include <vector>
+
+namespace PolLatBuilder {
+
+/**
+ * Set of coordinates (a projection) encoded as a bit mask: coordinate \f$j\f$
+ * belongs to the set if bit \f$j\f$ is set.
+ */
+typedef uint64_t ProjectionMask;
+
+/**
+ * Returns the bit mask of the projection on the coordinates \c coords.
+ */
+inline ProjectionMask projectionMask(const std::vector<Dimension>& coords)
+{
+   ProjectionMask u = 0;
+   for (const auto j : coords)
+      u |= ProjectionMask(1) << j;
+   return u;
+}
+
+/**
+ * Product weights: \f$\gamma_{\mathfrak u} = \prod_{j \in \mathfrak u}
+ * \gamma_j\f$.
+ */
+class ProductWeights {
+public:
+   /**
+    * Constructor.
+    *
+    * \param defaultWeight Weight of the coordinates not in \c weights.
+    * \param weights       Weights of the first coordinates.
+    */
+   explicit ProductWeights(Real defaultWeight = 1.0, RealVector weights = RealVector()):
+      m_defaultWeight(defaultWeight),
+      m_weights(std::move(weights))
+   {}
+
+   /**
+    * Returns the weight \f$\gamma_j\f$ of coordinate \c j.
+    */
+   Real weight(Dimension j) const
+   { return j < m_weights.size() ? m_weights[j] : m_defaultWeight; }
+
+   /**
+    * Sets the weight of coordinate \c j to \c weight.
+    */
+   void setWeight(Dimension j, Real weight)
+   {
+      if (j >= m_weights.size())
+         m_weights.resize(j + 1, m_defaultWeight);
+      m_weights[j] = weight;
+   }
+
+   /**
+    * Returns the weight of the coordinates without an explicit weight.
+    */
+   Real defaultWeight() const
+   { return m_defaultWeight; }
+
+   /**
+    * Returns the explicit weights of the first coordinates.
+    */
+   const RealVector& weights() const
+   { return m_weights; }
+
+private:
+   Real m_defaultWeight;
+   RealVector m_weights;
+};
+
+/**
+ * Order-dependent weights: \f$\gamma_{\mathfrak u} = \Gamma_{|\mathfrak u|}\f$.
+ *
+ * With a zero default weight, the weights are truncated: all projections of
+ * order larger than maxOrder() have zero weight.
+ */
+class OrderDependentWeights {
+public:
+   /**
+    * Constructor.
+    *
+    * \param weights       Weights \f$\Gamma_1, \Gamma_2, \dots\f$ of the first
+    *                      orders.
+    * \param defaultWeight Weight of the orders not in \c weights.
+    */
+   explicit OrderDependentWeights(RealVector weights = RealVector(), Real defaultWeight = 0.0):
+      m_defaultWeight(defaultWeight),
+      m_weights(std::move(weights))
+   {}
+
+   /**
+    * Returns the weight \f$\Gamma_{order}\f$ of projections of order \c
+    * order, for \c order >= 1.
+    */
+   Real weight(Dimension order) const
+   { return order - 1 < m_weights.size() ? m_weights[order - 1] : m_defaultWeight; }
+
+   /**
+    * Returns the weight of the orders without an explicit weight.
+    */
+   Real defaultWeight() const
+   { return m_defaultWeight; }
+
+   /**
+    * Returns the explicit weights of the first orders.
+    */
+   const RealVector& weights() const
+   { return m_weights; }
+
+   /**
+    * Returns the largest order with a nonzero weight, or 0 if the weights
+    * are not truncated.
+    */
+   Dimension maxOrder() const
+   {
+      if (m_defaultWeight != 0.0)
+         return 0;
+      Dimension order = m_weights.size();
+      while (order > 0 and m_weights[order - 1] == 0.0)
+         order--;
+      return order;
+   }
+
+private:
+   Real m_defaultWeight;
+   RealVector m_weights;
+};
+
+/**
+ * Product and order-dependent (POD) weights: \f$\gamma_{\mathfrak u} =
+ * \Gamma_{|\mathfrak u|} \prod_{j \in \mathfrak u} \gamma_j\f$.
+ *
+ * Product weights are obtained with \f$\Gamma_\ell = 1\f$ for all orders
+ * \f$\ell\f$ and order-dependent weights with \f$\gamma_j = 1\f$ for all
+ * coordinates \f$j\f$.
+ */
+class PODWeights {
+public:
+   /**
+    * Constructor.
+    */
+   PODWeights(
+         OrderDependentWeights orderDependentWeights = OrderDependentWeights(),
+         ProductWeights productWeights = ProductWeights()):
+      m_orderDependentWeights(std::move(orderDependentWeights)),
+      m_productWeights(std::move(productWeights))
+   {}
+
+   /**
+    * Returns the order-dependent part of the weights.
+    */
+   const OrderDependentWeights& orderDependentWeights() const
+   { return m_orderDependentWeights; }
+
+   /**
+    * Returns the product part of the weights.
+    */
+   const ProductWeights& productWeights() const
+   { return m_productWeights; }
+
+   /**
+    * Returns the largest order with a nonzero weight, or 0 if the weights
+    * are not truncated.
+    */
+   Dimension maxOrder() const
+   { return m_orderDependentWeights.maxOrder(); }
+
+private:
+   OrderDependentWeights m_orderDependentWeights;
+   ProductWeights m_productWeights;
+};
+
+/**
+ * Projection-dependent weights: an arbitrary weight \f$\gamma_{\mathfrak
+ * u}\f$ for each projection \f$\mathfrak u\f$.
+ *
+ * Only projections with a nonzero weight are stored, so this is suited to
+ * sparse sets of weighted projections.  Coordinates must be smaller than 64.
+ */
+class ProjectionDependentWeights {
+public:
+   typedef std::map<ProjectionMask, Real> Map;
+
+   /**
+    * Returns the weight of projection \c u.
+    */
+   Real weight(ProjectionMask u) const
+   {
+      const auto it = m_weights.find(u);
+      return it == m_weights.end() ? 0.0 : it->second;
+   }
+
+   /**
+    * Sets the weight of projection \c u to \c weight.
+    */
+   void setWeight(ProjectionMask u, Real weight)
+   {
+      if (weight == 0.0)
+         m_weights.erase(u);
+      else if (u != 0)
+         m_weights[u] = weight;
+   }
+
+   /**
+    * Returns all nonzero weights, by projection.
+    */
+   const Map& weights() const
+   { return m_weights; }
+
+private:
+   Map m_weights;
+};
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__DETAIL__ALIGNED_ALLOCATOR_H
+#define POLLATBUILDER__DETAIL__ALIGNED_ALLOCATOR_H
+
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+namespace PolLatBuilder { namespace detail {
+
+/**
+ * Standard allocator returning memory aligned on \c ALIGN bytes.
+ *
+ * Used for buffers that are meant to be processed with SIMD instructions, so
+ * that every row of a structure-of-arrays layout starts on a cache line.
+ */
+template <typename T, std::size_t ALIGN = 64>
+class AlignedAllocator {
+public:
+   typedef T value_type;
+
+   static constexpr std::size_t alignment = ALIGN;
+
+   template <typename U>
+   struct rebind { typedef AlignedAllocator<U, ALIGN> other; };
+
+   AlignedAllocator() = default;
+
+   template <typename U>
+   AlignedAllocator(const AlignedAllocator<U, ALIGN>&) {}
+
+   T* allocate(std::size_t n)
+   {
+      void* p = nullptr;
+      const std::size_t bytes = n > 0 ? n * sizeof(T) : ALIGN;
+      if (posix_memalign(&p, ALIGN, bytes) != 0)
+         throw std::bad_alloc();
+      return static_cast<T*>(p);
+   }
+
+   void deallocate(T* p, std::size_t)
+   { std::free(p); }
+
+   template <typename U>
+   bool operator==(const AlignedAllocator<U, ALIGN>&) const { return true; }
+
+   template <typename U>
+   bool operator!=(const AlignedAllocator<U, ALIGN>&) const { return false; }
+};
+
+}}
+
+#endif
@@ -0,0 +1,112 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POLLATBUILDER__DETAIL__BINARY_IO_H
+#define POLLATBUILDER__DETAIL__BINARY_IO_H
+
+#include "PolLatbuilder/Types.h"
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace PolLatBuilder { namespace detail {
+
+/**
+ * Writes the raw bytes of \c x to \c os, in the native byte order.
+ */
+template <typename T>
+void writeBinary(std::ostream& os, const T& x)
+{
+   static_assert(std::is_trivially_copyable<T>::value, "writeBinary: type must be trivially copyable");
+   os.write(reinterpret_cast<const char*>(&x), sizeof(T));
+}
+
+/**
+ * Writes the size of \c v followed by its elements to \c os.
+ */
+inline void writeBinary(std::ostream& os, const RealVector& v)
+{
+   writeBinary<uint64_t>(os, v.size());
+   os.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(Real));
+}
+
+/**
+ * Sequential reader of data written with writeBinary() from a memory
+ * region, such as a MappedFile.
+ *
+ * Reading past the end of the region throws \c std::runtime_error.
+ */
+class BinaryReader {
+public:
+   BinaryReader(const char* data, size_t size):
+      m_pos(data),
+      m_end(data + size)
+   {}
+
+   /**
+    * Returns the number of bytes left.
+    */
+   size_t remaining() const
+   { return m_end - m_pos; }
+
+   /**
+    * Reads and returns a value of type \c T.
+    */
+   template <typename T>
+   T read()
+   {
+      static_assert(std::is_trivially_copyable<T>::value, "BinaryReader: type must be trivially copyable");
+      T x;
+      std::memcpy(&x, take(sizeof(T)), sizeof(T));
+      return x;
+   }
+
+   /**
+    * Reads a vector written with writeBinary() into \c v.
+    */
+   void read(RealVector& v)
+   {
+      const uint64_t size = read<uint64_t>();
+      if (size > remaining() / sizeof(Real))
+         throw std::runtime_error("BinaryReader: unexpected end of data");
+      v.resize(size);
+      std::memcpy(v.data(), take(size * sizeof(Real)), size * sizeof(Real));
+   }
+
+   /**
+    * Skips the next \c bytes bytes and returns a pointer to them, which may
+    * not be suitably aligned for any type but \c char.
+    */
+   const char* take(size_t bytes)
+   {
+      if (bytes > remaining())
+         throw std::runtime_error("BinaryReader: unexpected end of data");
+      const char* p = m_pos;
+      m_pos += bytes;
+      return p;
+   }
+
+private:
+   const char* m_pos;
+   const char* m_end;
+};
+
+}}
+
+#endif
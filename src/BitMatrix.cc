@@ -0,0 +1,220 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PolLatbuilder/BitMatrix.h"
+#include "PolLatbuilder/Util.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace PolLatBuilder {
+
+namespace {
+
+   /**
+    * Number of rows combined in each table of the Method of Four Russians,
+    * close to \f$\log_2 n - \log_2 \log_2 n\f$ for \f$n\f$ rows.
+    */
+   BitMatrix::size_type m4riBlockSize(BitMatrix::size_type n)
+   {
+      BitMatrix::size_type k = 1;
+      while ((BitMatrix::size_type(1) << (k + 1)) * (k + 1) <= n)
+         k++;
+      return std::min<BitMatrix::size_type>(k, 8);
+   }
+
+   /**
+    * Fills \c table with all linear combinations of the \c k rows given by \c
+    * rows, from word \c first to word \c first + \c width, in Gray-code order
+    * so that each entry costs a single row addition.
+    *
+    * Bit \f$t\f$ of the index of an entry selects row \f$t\f$.
+    */
+   void makeTable(
+         std::vector<BitMatrix::word_type>& table,
+         const std::vector<const BitMatrix::word_type*>& rows,
+         BitMatrix::size_type first,
+         BitMatrix::size_type width)
+   {
+      const size_t size = size_t(1) << rows.size();
+      table.assign(size * width, 0);
+      for (size_t g = 1; g < size; g++) {
+         const size_t prev = ((g - 1) ^ ((g - 1) >> 1)) * width;
+         const size_t cur = (g ^ (g >> 1)) * width;
+         const auto src = rows[trailingZeros(g)] + first;
+         for (BitMatrix::size_type w = 0; w < width; w++)
+            table[cur + w] = table[prev + w] ^ src[w];
+      }
+   }
+
+   inline bool getBit(const BitMatrix::word_type* row, BitMatrix::size_type j)
+   { return (row[j / 64] >> (j % 64)) & 1; }
+}
+
+//================================================================================
+
+BitMatrix::BitMatrix(const GeneratingMatrix& mat)
+{
+   resize(mat.size1(), mat.size2());
+   for (size_type i = 0; i < m_size1; i++)
+      for (size_type j = 0; j < m_size2; j++)
+         if (mat(i, j))
+            (*this)(i, j) = true;
+}
+
+void BitMatrix::swapRows(size_type i, size_type k)
+{
+   if (i == k)
+      return;
+   std::swap_ranges(row(i), row(i) + m_wordsPerRow, row(k));
+}
+
+BitMatrix BitMatrix::transpose() const
+{
+   BitMatrix t(m_size2, m_size1);
+   for (size_type i = 0; i < m_size1; i++) {
+      const word_type* r = row(i);
+      for (size_type w = 0; w < m_wordsPerRow; w++) {
+         // visit the nonzero elements only
+         for (word_type x = r[w]; x; x &= x - 1)
+            t(64 * w + trailingZeros(x), i) = true;
+      }
+   }
+   return t;
+}
+
+//================================================================================
+
+BitMatrix::size_type BitMatrix::gaussSubmatrix(size_type r, size_type c, size_type k, std::vector<size_type>& pivots)
+{
+   const size_type first = c / 64;
+   pivots.clear();
+   for (size_type cc = c; cc < c + k; cc++) {
+      const size_type found = pivots.size();
+      for (size_type i = r + found; i < m_size1; i++) {
+         word_type* ri = row(i);
+         // eliminate the pivots already found in this stripe
+         for (size_type t = 0; t < found; t++)
+            if (getBit(ri, pivots[t]))
+               addRow(ri, row(r + t), first);
+         if (not getBit(ri, cc))
+            continue;
+         swapRows(i, r + found);
+         // keep the pivot rows reduced with respect to each other
+         for (size_type t = 0; t < found; t++)
+            if (getBit(row(r + t), cc))
+               addRow(row(r + t), row(r + found), first);
+         pivots.push_back(cc);
+         break;
+      }
+   }
+   return pivots.size();
+}
+
+BitMatrix::size_type BitMatrix::echelonize(bool reduced)
+{
+   const size_type k = m4riBlockSize(m_size1);
+   std::vector<size_type> pivots;
+   std::vector<const word_type*> pivotRows;
+   std::vector<word_type> table;
+
+   size_type r = 0;
+   for (size_type c = 0; c < m_size2 and r < m_size1; c += k) {
+      const size_type kk = std::min(k, m_size2 - c);
+      const size_type found = gaussSubmatrix(r, c, kk, pivots);
+      if (found == 0)
+         continue;
+
+      // table of all combinations of the pivot rows
+      const size_type first = c / 64;
+      const size_type width = m_wordsPerRow - first;
+      pivotRows.clear();
+      for (size_type t = 0; t < found; t++)
+         pivotRows.push_back(row(r + t));
+      makeTable(table, pivotRows, first, width);
+
+      // clear the pivot columns of the other rows with one table lookup each
+      for (size_type i = reduced ? 0 : r + found; i < m_size1; i++) {
+         if (i == r) {
+            i += found - 1;
+            continue;
+         }
+         word_type* ri = row(i);
+         size_t index = 0;
+         for (size_type t = 0; t < found; t++)
+            index |= size_t(getBit(ri, pivots[t])) << t;
+         if (index) {
+            const word_type* src = table.data() + index * width;
+            for (size_type w = 0; w < width; w++)
+               ri[first + w] ^= src[w];
+         }
+      }
+      r += found;
+   }
+   return r;
+}
+
+BitMatrix::size_type BitMatrix::rank() const
+{
+   BitMatrix copy(*this);
+   return copy.echelonize(false);
+}
+
+//================================================================================
+
+BitMatrix operator*(const BitMatrix& a, const BitMatrix& b)
+{
+   if (a.size2() != b.size1())
+      throw std::runtime_error("BitMatrix: incompatible dimensions for multiplication");
+
+   typedef BitMatrix::size_type size_type;
+   BitMatrix c(a.size1(), b.size2());
+   const size_type width = b.wordsPerRow();
+   const size_type k = 8;
+   std::vector<const BitMatrix::word_type*> rows;
+   std::vector<BitMatrix::word_type> table;
+
+   for (size_type l = 0; l < b.size1(); l += k) {
+      const size_type kk = std::min(k, b.size1() - l);
+      rows.clear();
+      for (size_type t = 0; t < kk; t++)
+         rows.push_back(b.row(l + t));
+      makeTable(table, rows, 0, width);
+
+      // blocks of 8 columns never straddle two words
+      const size_type word = l / 64;
+      const unsigned shift = l % 64;
+      for (size_type i = 0; i < a.size1(); i++) {
+         const size_t index = (a.row(i)[word] >> shift) & 0xff;
+         if (index)
+            c.addRow(c.row(i), table.data() + index * width, 0);
+      }
+   }
+   return c;
+}
+
+std::ostream& operator<<(std::ostream& os, const BitMatrix& mat)
+{
+   for (BitMatrix::size_type i = 0; i < mat.size1(); i++) {
+      if (i > 0)
+         os << '\n';
+      for (BitMatrix::size_type j = 0; j < mat.size2(); j++)
+         os << (mat(i, j) ? '1' : '0');
+   }
+   return os;
+}
+
+}
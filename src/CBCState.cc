@@ -0,0 +1,123 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PolLatbuilder/MeritSeq/CBCState.h"
+#include "PolLatbuilder/MappedFile.h"
+#include "PolLatbuilder/Util.h"
+#include "PolLatbuilder/detail/BinaryIO.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace PolLatBuilder { namespace MeritSeq {
+
+using detail::writeBinary;
+
+namespace {
+   const char MAGIC[8] = {'P', 'L', 'B', 'C', 'B', 'C', '0', '2'};
+   const uint32_t BYTE_ORDER_MARK = 0x01020304;
+}
+
+void CBCState::save(
+      const std::string& path,
+      const LatDef<LatType::ORDINARY>& baseLat,
+      Real baseMerit,
+      Precision precision,
+      Real precisionError,
+      const Poly& embeddedModulus,
+      const std::string& accumulator,
+      const RealVector& kernelValues,
+      const CoordUniformState& state)
+{
+   std::ofstream os(path, std::ios::binary | std::ios::trunc);
+   if (not os)
+      throw std::runtime_error("CBCState: cannot open " + path + " for writing");
+
+   os.write(MAGIC, sizeof(MAGIC));
+   writeBinary(os, BYTE_ORDER_MARK);
+   writeBinary<uint64_t>(os, polyToInt(baseLat.sizeParam().polynomial()));
+   writeBinary<uint64_t>(os, baseLat.dimension());
+   for (const auto& g : baseLat.gen())
+      writeBinary<uint64_t>(os, polyToInt(rep(g)));
+   writeBinary(os, baseMerit);
+   writeBinary<uint32_t>(os, static_cast<uint32_t>(precision));
+   writeBinary(os, precisionError);
+   writeBinary<uint32_t>(os, static_cast<uint32_t>(state.precision()));
+   writeBinary<uint64_t>(os, polyToInt(embeddedModulus));
+   writeBinary<uint64_t>(os, accumulator.size());
+   os.write(accumulator.data(), accumulator.size());
+   writeBinary(os, kernelValues);
+   state.save(os);
+
+   os.flush();
+   if (not os)
+      throw std::runtime_error("CBCState: error while writing " + path);
+}
+
+CBCState CBCState::load(const std::string& path, const StateStorage& storage)
+{
+   MappedFile file(path);
+   file.advise(MappedFile::Access::SEQUENTIAL);
+   detail::BinaryReader in(file.data(), file.size());
+
+   char magic[sizeof(MAGIC)];
+   for (auto& c : magic)
+      c = in.read<char>();
+   if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+      throw std::runtime_error("CBCState: " + path + " is not a CBC state file");
+   if (in.read<uint32_t>() != BYTE_ORDER_MARK)
+      throw std::runtime_error("CBCState: " + path + " was written with another byte order");
+
+   const Poly modulus = intToPoly(in.read<uint64_t>());
+   const Poly& current = PolyModP::modulus();
+   if (current != modulus)
+      throw std::runtime_error("CBCState: the PolyModP modulus differs from that of the saved lattice");
+
+   CBCState s;
+   s.baseLat = LatDef<LatType::ORDINARY>(SizeParam<LatType::ORDINARY>(modulus));
+   const uint64_t dimension = in.read<uint64_t>();
+   if (dimension > in.remaining() / sizeof(uint64_t))
+      throw std::runtime_error("CBCState: invalid file " + path);
+   s.baseLat.gen().reserve(dimension);
+   for (uint64_t j = 0; j < dimension; j++)
+      s.baseLat.gen().push_back(conv<PolyModP>(intToPoly(in.read<uint64_t>())));
+   s.baseMerit = in.read<Real>();
+   const uint32_t precision = in.read<uint32_t>();
+   s.precisionError = in.read<Real>();
+   const uint32_t statePrecision = in.read<uint32_t>();
+   if (precision > static_cast<uint32_t>(Precision::SINGLE) or statePrecision > static_cast<uint32_t>(Precision::SINGLE))
+      throw std::runtime_error("CBCState: invalid file " + path);
+   s.precision = static_cast<Precision>(precision);
+   s.embeddedModulus = intToPoly(in.read<uint64_t>());
+   const uint64_t nameSize = in.read<uint64_t>();
+   if (nameSize > in.remaining())
+      throw std::runtime_error("CBCState: invalid file " + path);
+   for (uint64_t i = 0; i < nameSize; i++)
+      s.accumulator.push_back(in.read<char>());
+   in.read(s.kernelValues);
+   // a state already converted to double precision is restored as such
+   StateStorage stateStorage = storage;
+   if (static_cast<Precision>(statePrecision) == Precision::DOUBLE)
+      stateStorage.precision = Precision::DOUBLE;
+   s.state = CoordUniformStateCreator::load(in, stateStorage);
+
+   if (s.state->dimension() != dimension or s.state->numPoints() != s.baseLat.sizeParam().numPoints())
+      throw std::runtime_error("CBCState: the state does not match the lattice in " + path);
+   return s;
+}
+
+}}
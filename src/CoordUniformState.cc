@@ -0,0 +1,478 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PolLatbuilder/MeritSeq/CoordUniformState.h"
+
+#include "PolLatbuilder/Util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+namespace PolLatBuilder { namespace MeritSeq {
+
+using detail::writeBinary;
+
+namespace {
+   /**
+    * Returns the largest absolute value of the kernel values.
+    */
+   Real maxAbs(const StateVector& kernelValues)
+   {
+      const Real* x = kernelValues.data();
+      Real m = 0.0;
+      for (Modulus i = 0; i < kernelValues.size(); i++)
+         m = std::max(m, std::abs(x[i]));
+      return m;
+   }
+
+   /**
+    * Writes \c v in double precision in the format of writeBinary() for a
+    * RealVector, block by block, so that a mapped vector is never copied
+    * whole in memory, followed by its error bound.
+    */
+   void writeStateVector(std::ostream& os, const StateVector& v)
+   {
+      const Modulus blockSize = 1 << 16;
+      RealVector buffer(std::min(v.size(), blockSize));
+      writeBinary<uint64_t>(os, v.size());
+      for (Modulus first = 0; first < v.size(); first += blockSize) {
+         const Modulus count = std::min(blockSize, v.size() - first);
+         os.write(reinterpret_cast<const char*>(v.block(first, count, buffer.data())), count * sizeof(Real));
+      }
+      writeBinary(os, v.error());
+   }
+
+   /**
+    * Reads a vector written with writeStateVector() and stores it in \c
+    * storage; its error bound is the saved one plus the rounding error of
+    * the storage.  Returns \c false if it does not have \c numPoints
+    * elements.
+    */
+   bool readStateVector(detail::BinaryReader& in, Modulus numPoints, const StateStorage& storage, StateVector& v)
+   {
+      const uint64_t size = in.read<uint64_t>();
+      if (size != numPoints or size > in.remaining() / sizeof(Real))
+         return false;
+      const char* x = in.take(size * sizeof(Real));
+      v = StateVector(numPoints, 0.0, storage);
+      const Real rounding = v.transform([x](Modulus i, Real) {
+               Real y;
+               std::memcpy(&y, x + i * sizeof(Real), sizeof(Real));
+               return y;
+               });
+      v.setError(in.read<Real>() + rounding);
+      return true;
+   }
+}
+
+//================================================================================
+// CoordUniformState
+//================================================================================
+
+void CoordUniformState::saveHeader(std::ostream& os, Type type) const
+{
+   writeBinary<uint32_t>(os, static_cast<uint32_t>(type));
+   writeBinary<uint64_t>(os, m_numPoints);
+   writeBinary<uint64_t>(os, m_dimension);
+}
+
+//================================================================================
+// ProductState
+//================================================================================
+
+ProductState::ProductState(Modulus numPoints, ProductWeights weights, const StateStorage& storage):
+   CoordUniformState(numPoints, storage),
+   m_weights(std::move(weights)),
+   m_state(storage),
+   m_weightedState(storage)
+{ reset(); }
+
+void ProductState::setPrecision(Precision precision)
+{
+   m_state.setPrecision(precision);
+   m_weightedState.setPrecision(precision);
+   CoordUniformState::setPrecision(precision);
+}
+
+void ProductState::reset()
+{
+   CoordUniformState::reset();
+   m_state.assign(numPoints(), 1.0);
+   updateWeightedState();
+}
+
+void ProductState::update(const StateVector& kernelValues)
+{
+   const Real gamma = m_weights.weight(dimension());
+   const Real* w = kernelValues.data();
+   Real maxFactor = 0.0;
+   const Real rounding = m_state.transform([&](Modulus i, Real p) {
+         const Real factor = 1.0 + gamma * w[i];
+         maxFactor = std::max(maxFactor, std::abs(factor));
+         return p * factor;
+         }, {&kernelValues});
+   m_state.setError(m_state.error() * maxFactor + rounding);
+   CoordUniformState::update(kernelValues);
+   updateWeightedState();
+}
+
+void ProductState::save(std::ostream& os) const
+{
+   saveHeader(os, Type::PRODUCT);
+   writeBinary(os, m_weights.defaultWeight());
+   writeBinary(os, m_weights.weights());
+   writeStateVector(os, m_state);
+}
+
+std::unique_ptr<CoordUniformState> ProductState::load(detail::BinaryReader& in, Modulus numPoints, Dimension dimension, const StateStorage& storage)
+{
+   const Real defaultWeight = in.read<Real>();
+   RealVector weights;
+   in.read(weights);
+   std::unique_ptr<ProductState> state(new ProductState(numPoints, ProductWeights(defaultWeight, std::move(weights)), storage));
+   if (not readStateVector(in, numPoints, storage, state->m_state))
+      throw std::runtime_error("ProductState: invalid saved state");
+   state->setDimension(dimension);
+   state->updateWeightedState();
+   return std::unique_ptr<CoordUniformState>(std::move(state));
+}
+
+void ProductState::updateWeightedState()
+{
+   const Real gamma = m_weights.weight(dimension());
+   if (m_weightedState.size() != numPoints())
+      m_weightedState.assign(numPoints(), 0.0);
+   const Real rounding = m_weightedState.transform([&](Modulus i, Real) { return gamma * m_state[i]; }, {&m_state});
+   m_weightedState.setError(std::abs(gamma) * m_state.error() + rounding);
+}
+
+//================================================================================
+// PODState
+//================================================================================
+
+PODState::PODState(Modulus numPoints, PODWeights weights, const StateStorage& storage):
+   CoordUniformState(numPoints, storage),
+   m_weights(std::move(weights)),
+   m_weightedState(storage)
+{ reset(); }
+
+void PODState::setPrecision(Precision precision)
+{
+   for (auto& p : m_state)
+      p.setPrecision(precision);
+   m_weightedState.setPrecision(precision);
+   CoordUniformState::setPrecision(precision);
+}
+
+size_t PODState::bytes() const
+{
+   size_t total = m_weightedState.bytes();
+   for (const auto& p : m_state)
+      total += p.bytes();
+   return total;
+}
+
+void PODState::reset()
+{
+   CoordUniformState::reset();
+   m_state.clear();
+   updateWeightedState();
+}
+
+void PODState::update(const StateVector& kernelValues)
+{
+   const Real gamma = m_weights.productWeights().weight(dimension());
+
+   // orders 1 to L - 1 are needed for the weighted state
+   const Dimension maxOrder = m_weights.maxOrder();
+   const Dimension numOrders = maxOrder ? std::min<Dimension>(dimension() + 1, maxOrder - 1) : dimension() + 1;
+   while (m_state.size() < numOrders)
+      m_state.emplace_back(numPoints(), 0.0, storage());
+
+   // from the highest order down, so that p_{l-1} is still the old value
+   const Real* w = kernelValues.data();
+   const Real factor = std::abs(gamma) * maxAbs(kernelValues);
+   for (Dimension l = m_state.size(); l >= 2; l--) {
+      StateVector& p = m_state[l - 1];
+      const StateVector& pPrev = m_state[l - 2];
+      const Real rounding = p.transform([&](Modulus i, Real x) { return x + gamma * w[i] * pPrev[i]; }, {&kernelValues, &pPrev});
+      p.setError(p.error() + factor * pPrev.error() + rounding);
+   }
+   if (not m_state.empty()) {
+      StateVector& p = m_state[0];
+      const Real rounding = p.transform([&](Modulus i, Real x) { return x + gamma * w[i]; }, {&kernelValues});
+      p.setError(p.error() + rounding);
+   }
+
+   CoordUniformState::update(kernelValues);
+   updateWeightedState();
+}
+
+void PODState::save(std::ostream& os) const
+{
+   saveHeader(os, Type::POD);
+   const OrderDependentWeights& orderWeights = m_weights.orderDependentWeights();
+   const ProductWeights& productWeights = m_weights.productWeights();
+   writeBinary(os, orderWeights.defaultWeight());
+   writeBinary(os, orderWeights.weights());
+   writeBinary(os, productWeights.defaultWeight());
+   writeBinary(os, productWeights.weights());
+   writeBinary<uint64_t>(os, m_state.size());
+   for (const auto& p : m_state)
+      writeStateVector(os, p);
+}
+
+std::unique_ptr<CoordUniformState> PODState::load(detail::BinaryReader& in, Modulus numPoints, Dimension dimension, const StateStorage& storage)
+{
+   const Real orderDefault = in.read<Real>();
+   RealVector orderWeights;
+   in.read(orderWeights);
+   const Real productDefault = in.read<Real>();
+   RealVector productWeights;
+   in.read(productWeights);
+   std::unique_ptr<PODState> state(new PODState(numPoints, PODWeights(
+               OrderDependentWeights(std::move(orderWeights), orderDefault),
+               ProductWeights(productDefault, std::move(productWeights))), storage));
+   const uint64_t numOrders = in.read<uint64_t>();
+   if (numOrders > dimension)
+      throw std::runtime_error("PODState: invalid saved state");
+   state->m_state.resize(numOrders);
+   for (auto& p : state->m_state) {
+      if (not readStateVector(in, numPoints, storage, p))
+         throw std::runtime_error("PODState: invalid saved state");
+   }
+   state->setDimension(dimension);
+   state->updateWeightedState();
+   return std::unique_ptr<CoordUniformState>(std::move(state));
+}
+
+void PODState::updateWeightedState()
+{
+   const Real gamma = m_weights.productWeights().weight(dimension());
+   const OrderDependentWeights& orderWeights = m_weights.orderDependentWeights();
+
+   // terms w p_l with nonzero weights, added in increasing order
+   std::vector<std::pair<Real, const StateVector*>> terms;
+   std::vector<const StateVector*> sources;
+   Real error = 0.0;
+   for (Dimension l = 1; l <= m_state.size(); l++) {
+      const Real w = gamma * orderWeights.weight(l + 1);
+      if (w == 0.0)
+         continue;
+      terms.emplace_back(w, &m_state[l - 1]);
+      sources.push_back(&m_state[l - 1]);
+      error += std::abs(w) * m_state[l - 1].error();
+   }
+
+   const Real first = gamma * orderWeights.weight(1);
+   if (m_weightedState.size() != numPoints())
+      m_weightedState.assign(numPoints(), 0.0);
+   const Real rounding = m_weightedState.transform([&](Modulus i, Real) {
+         Real q = first;
+         for (const auto& term : terms)
+            q += term.first * (*term.second)[i];
+         return q;
+         }, sources);
+   m_weightedState.setError(error + rounding);
+}
+
+//================================================================================
+// ProjectionDependentState
+//================================================================================
+
+ProjectionDependentState::ProjectionDependentState(Modulus numPoints, ProjectionDependentWeights weights, const StateStorage& storage):
+   CoordUniformState(numPoints, storage),
+   m_weights(std::move(weights)),
+   m_weightedState(storage)
+{
+   for (const auto& w : m_weights.weights()) {
+      const ProjectionMask u = w.first;
+      const Dimension last = 63 - leadingZeros(u);
+      const ProjectionMask rest = u ^ (ProjectionMask(1) << last);
+      if (m_projections.size() <= last)
+         m_projections.resize(last + 1);
+      m_projections[last].push_back(WeightedProjection{rest, w.second});
+
+      // chain of partial products leading to rest
+      ProjectionMask v = 0;
+      for (ProjectionMask r = rest; r; r &= r - 1) {
+         const Dimension j = trailingZeros(r);
+         v |= ProjectionMask(1) << j;
+         auto it = m_lastUse.find(v);
+         if (it == m_lastUse.end()) {
+            m_lastUse[v] = last;
+            if (m_partials.size() <= j)
+               m_partials.resize(j + 1);
+            m_partials[j].push_back(v);
+         }
+         else
+            it->second = std::max(it->second, last);
+      }
+   }
+   reset();
+}
+
+void ProjectionDependentState::setPrecision(Precision precision)
+{
+   for (auto& entry : m_cache)
+      entry.second.setPrecision(precision);
+   m_weightedState.setPrecision(precision);
+   CoordUniformState::setPrecision(precision);
+}
+
+size_t ProjectionDependentState::bytes() const
+{
+   size_t total = m_weightedState.bytes();
+   for (const auto& entry : m_cache)
+      total += entry.second.bytes();
+   return total;
+}
+
+void ProjectionDependentState::reset()
+{
+   CoordUniformState::reset();
+   m_cache.clear();
+   updateWeightedState();
+}
+
+void ProjectionDependentState::update(const StateVector& kernelValues)
+{
+   const Dimension c = dimension();
+
+   if (c < m_partials.size()) {
+      // c < 64, since partial products only contain coordinates of masks
+      const ProjectionMask bit = ProjectionMask(1) << c;
+      const Real* w = kernelValues.data();
+      const Real maxKernel = maxAbs(kernelValues);
+      for (const auto v : m_partials[c]) {
+         const ProjectionMask parent = v ^ bit;
+         const StateVector* pp = parent ? &m_cache.at(parent) : nullptr;
+         StateVector p(numPoints(), 0.0, storage());
+         std::vector<const StateVector*> sources{&kernelValues};
+         if (pp)
+            sources.push_back(pp);
+         const Real rounding = p.transform([&](Modulus i, Real) {
+               return pp ? w[i] * (*pp)[i] : w[i];
+               }, sources);
+         p.setError((pp ? maxKernel * pp->error() : 0.0) + rounding);
+         m_cache[v] = std::move(p);
+      }
+   }
+
+   // discard the partial products that will not be used any more
+   for (auto it = m_cache.begin(); it != m_cache.end(); ) {
+      if (m_lastUse.at(it->first) <= c)
+         it = m_cache.erase(it);
+      else
+         ++it;
+   }
+
+   CoordUniformState::update(kernelValues);
+   updateWeightedState();
+}
+
+void ProjectionDependentState::save(std::ostream& os) const
+{
+   saveHeader(os, Type::PROJECTION_DEPENDENT);
+   writeBinary<uint64_t>(os, m_weights.weights().size());
+   for (const auto& w : m_weights.weights()) {
+      writeBinary(os, w.first);
+      writeBinary(os, w.second);
+   }
+   // in a deterministic order
+   std::map<ProjectionMask, const StateVector*> cache;
+   for (const auto& entry : m_cache)
+      cache[entry.first] = &entry.second;
+   writeBinary<uint64_t>(os, cache.size());
+   for (const auto& entry : cache) {
+      writeBinary(os, entry.first);
+      writeStateVector(os, *entry.second);
+   }
+}
+
+std::unique_ptr<CoordUniformState> ProjectionDependentState::load(detail::BinaryReader& in, Modulus numPoints, Dimension dimension, const StateStorage& storage)
+{
+   ProjectionDependentWeights weights;
+   for (uint64_t count = in.read<uint64_t>(); count > 0; count--) {
+      const ProjectionMask u = in.read<ProjectionMask>();
+      weights.setWeight(u, in.read<Real>());
+   }
+   std::unique_ptr<ProjectionDependentState> state(new ProjectionDependentState(numPoints, std::move(weights), storage));
+   for (uint64_t count = in.read<uint64_t>(); count > 0; count--) {
+      const ProjectionMask v = in.read<ProjectionMask>();
+      StateVector& p = state->m_cache[v];
+      if (not readStateVector(in, numPoints, storage, p) or not state->m_lastUse.count(v))
+         throw std::runtime_error("ProjectionDependentState: invalid saved state");
+   }
+   state->setDimension(dimension);
+   state->updateWeightedState();
+   return std::unique_ptr<CoordUniformState>(std::move(state));
+}
+
+void ProjectionDependentState::updateWeightedState()
+{
+   const Dimension c = dimension();
+   m_weightedState.assign(numPoints(), 0.0);
+   if (c >= m_projections.size())
+      return;
+
+   // terms w p, with p = 1 for the projection {c}, in the order of the
+   // projections
+   std::vector<std::pair<Real, const StateVector*>> terms;
+   std::vector<const StateVector*> sources;
+   Real error = 0.0;
+   for (const auto& proj : m_projections[c]) {
+      const StateVector* p = proj.rest ? &m_cache.at(proj.rest) : nullptr;
+      terms.emplace_back(proj.weight, p);
+      if (p) {
+         sources.push_back(p);
+         error += std::abs(proj.weight) * p->error();
+      }
+   }
+
+   const Real rounding = m_weightedState.transform([&](Modulus i, Real) {
+         Real q = 0.0;
+         for (const auto& term : terms)
+            q += term.second ? term.first * (*term.second)[i] : term.first;
+         return q;
+         }, sources);
+   m_weightedState.setError(error + rounding);
+}
+
+//================================================================================
+// CoordUniformStateCreator
+//================================================================================
+
+std::unique_ptr<CoordUniformState> CoordUniformStateCreator::load(detail::BinaryReader& in, const StateStorage& storage)
+{
+   const uint32_t type = in.read<uint32_t>();
+   const Modulus numPoints = in.read<uint64_t>();
+   const Dimension dimension = in.read<uint64_t>();
+   switch (static_cast<CoordUniformState::Type>(type)) {
+      case CoordUniformState::Type::PRODUCT:
+         return ProductState::load(in, numPoints, dimension, storage);
+      case CoordUniformState::Type::POD:
+         return PODState::load(in, numPoints, dimension, storage);
+      case CoordUniformState::Type::PROJECTION_DEPENDENT:
+         return ProjectionDependentState::load(in, numPoints, dimension, storage);
+   }
+   throw std::runtime_error("CoordUniformStateCreator: unknown saved state type");
+}
+
+}}
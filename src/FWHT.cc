@@ -0,0 +1,82 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PolLatbuilder/FWHT.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace PolLatBuilder {
+
+namespace {
+   /// Number of values transformed together in the first stages (32 KiB).
+   const size_t BLOCK_SIZE = 4096;
+}
+
+void fwht(Real* data, size_t n)
+{
+   if (n == 0)
+      return;
+   if (n & (n - 1))
+      throw std::runtime_error("fwht: length must be a power of 2");
+
+   // stages with butterflies inside blocks
+   const size_t block = std::min(n, BLOCK_SIZE);
+   for (size_t b = 0; b < n; b += block) {
+      Real* a = data + b;
+      for (size_t h = 1; h < block; h *= 2) {
+         for (size_t i = 0; i < block; i += 2 * h) {
+            for (size_t j = i; j < i + h; j++) {
+               const Real u = a[j];
+               const Real v = a[j + h];
+               a[j] = u + v;
+               a[j + h] = u - v;
+            }
+         }
+      }
+   }
+
+   // remaining stages, two at a time (radix 4)
+   size_t h = block;
+   for (; 4 * h <= n; h *= 4) {
+      for (size_t i = 0; i < n; i += 4 * h) {
+         Real* a0 = data + i;
+         Real* a1 = a0 + h;
+         Real* a2 = a1 + h;
+         Real* a3 = a2 + h;
+         for (size_t j = 0; j < h; j++) {
+            const Real s01 = a0[j] + a1[j];
+            const Real d01 = a0[j] - a1[j];
+            const Real s23 = a2[j] + a3[j];
+            const Real d23 = a2[j] - a3[j];
+            a0[j] = s01 + s23;
+            a1[j] = d01 + d23;
+            a2[j] = s01 - s23;
+            a3[j] = d01 - d23;
+         }
+      }
+   }
+   if (h < n) {
+      for (size_t j = 0; j < h; j++) {
+         const Real u = data[j];
+         const Real v = data[j + h];
+         data[j] = u + v;
+         data[j + h] = u - v;
+      }
+   }
+}
+
+}
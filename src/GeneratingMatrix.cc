@@ -0,0 +1,78 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PolLatbuilder/GeneratingMatrix.h"
+#include "PolLatbuilder/Util.h"
+
+#include <stdexcept>
+
+namespace PolLatBuilder {
+
+GeneratingMatrix::GeneratingMatrix(size_type numRows, std::vector<uint64_t> columns):
+   m_numRows(numRows),
+   m_columns(std::move(columns))
+{
+   if (m_numRows < 0 or m_numRows > 64)
+      throw std::runtime_error("GeneratingMatrix: number of rows must be in 0..64");
+   if (m_columns.size() > 64)
+      throw std::runtime_error("GeneratingMatrix: number of columns must be at most 64");
+}
+
+std::vector<uint64_t>
+GeneratingMatrix::rows() const
+{
+   const size_type n = size2();
+   std::vector<uint64_t> rows(m_numRows, 0);
+   for (size_type j = 0; j < n; j++) {
+      const uint64_t bit = uint64_t(1) << (n - 1 - j);
+      uint64_t col = m_columns[j];
+      // visit the nonzero elements of the column only
+      while (col) {
+         const unsigned b = 63 - leadingZeros(col);
+         rows[m_numRows - 1 - b] |= bit;
+         col ^= uint64_t(1) << b;
+      }
+   }
+   return rows;
+}
+
+std::ostream& operator<<(std::ostream& os, const GeneratingMatrix& mat)
+{
+   for (GeneratingMatrix::size_type i = 0; i < mat.size1(); i++) {
+      if (i > 0)
+         os << '\n';
+      for (GeneratingMatrix::size_type j = 0; j < mat.size2(); j++)
+         os << (mat(i, j) ? '1' : '0');
+   }
+   return os;
+}
+
+std::vector<GeneratingMatrix> generatingMatrices(const LatDef<LatType::ORDINARY>& lat)
+{
+   const Poly& P = lat.sizeParam().polynomial();
+   const long m = deg(P);
+   if (m < 1 or m > 63)
+      throw std::runtime_error("generatingMatrices: modulus degree must be in 1..63");
+
+   const Modulus modulus = polyToInt(P);
+   std::vector<GeneratingMatrix> mats;
+   mats.reserve(lat.dimension());
+   for (const auto& g : lat.gen())
+      mats.emplace_back(m, laurentColumns(polyToInt(rep(g)), modulus, m, m));
+   return mats;
+}
+
+}
@@ -0,0 +1,176 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PolLatbuilder/MappedFile.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace PolLatBuilder {
+
+namespace {
+   void advise(void* data, size_t size, MappedFile::Access access, size_t offset, size_t length)
+   {
+      if (not data or offset >= size)
+         return;
+      length = std::min(length, size - offset);
+      // madvise() needs a page-aligned address
+      const size_t page = ::sysconf(_SC_PAGESIZE);
+      const size_t begin = offset / page * page;
+      int advice = MADV_NORMAL;
+      switch (access) {
+         case MappedFile::Access::NORMAL: advice = MADV_NORMAL; break;
+         case MappedFile::Access::SEQUENTIAL: advice = MADV_SEQUENTIAL; break;
+         case MappedFile::Access::RANDOM: advice = MADV_RANDOM; break;
+         case MappedFile::Access::WILLNEED: advice = MADV_WILLNEED; break;
+         case MappedFile::Access::DONTNEED: advice = MADV_DONTNEED; break;
+      }
+      ::madvise(static_cast<char*>(data) + begin, offset + length - begin, advice);
+   }
+}
+
+//================================================================================
+
+MappedFile::MappedFile(const std::string& path):
+   m_data(nullptr),
+   m_size(0)
+{
+   const int fd = ::open(path.c_str(), O_RDONLY);
+   if (fd < 0)
+      throw std::runtime_error("MappedFile: cannot open " + path + ": " + std::strerror(errno));
+   struct stat st;
+   if (::fstat(fd, &st) != 0) {
+      const int err = errno;
+      ::close(fd);
+      throw std::runtime_error("MappedFile: cannot stat " + path + ": " + std::strerror(err));
+   }
+   m_size = st.st_size;
+   if (m_size > 0) {
+      void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+         const int err = errno;
+         ::close(fd);
+         throw std::runtime_error("MappedFile: cannot map " + path + ": " + std::strerror(err));
+      }
+      m_data = p;
+   }
+   // the mapping stays valid after the descriptor is closed
+   ::close(fd);
+}
+
+MappedFile::MappedFile(MappedFile&& other):
+   m_data(other.m_data),
+   m_size(other.m_size)
+{
+   other.m_data = nullptr;
+   other.m_size = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+   if (this != &other) {
+      release();
+      std::swap(m_data, other.m_data);
+      std::swap(m_size, other.m_size);
+   }
+   return *this;
+}
+
+MappedFile::~MappedFile()
+{ release(); }
+
+void MappedFile::release()
+{
+   if (m_data)
+      ::munmap(m_data, m_size);
+   m_data = nullptr;
+   m_size = 0;
+}
+
+void MappedFile::advise(Access access, size_t offset, size_t length) const
+{ PolLatBuilder::advise(m_data, m_size, access, offset, length); }
+
+//================================================================================
+
+MappedTempFile::MappedTempFile(const std::string& directory, size_t size):
+   m_data(nullptr),
+   m_size(0)
+{
+   std::string path = (directory.empty() ? std::string(".") : directory) + "/pollatbuilder-XXXXXX";
+   const int fd = ::mkstemp(&path[0]);
+   if (fd < 0)
+      throw std::runtime_error("MappedTempFile: cannot create a file in " + directory + ": " + std::strerror(errno));
+   // the file is removed with the last reference to it, the mapping
+   ::unlink(path.c_str());
+   if (size > 0) {
+      const int err = ::posix_fallocate(fd, 0, size);
+      if (err != 0) {
+         ::close(fd);
+         throw std::runtime_error("MappedTempFile: cannot allocate " + std::to_string(size) + " bytes in " + directory + ": " + std::strerror(err));
+      }
+      void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED) {
+         const int err = errno;
+         ::close(fd);
+         throw std::runtime_error("MappedTempFile: cannot map a file in " + directory + ": " + std::strerror(err));
+      }
+      m_data = p;
+      m_size = size;
+   }
+   ::close(fd);
+}
+
+MappedTempFile::MappedTempFile(MappedTempFile&& other):
+   m_data(other.m_data),
+   m_size(other.m_size)
+{
+   other.m_data = nullptr;
+   other.m_size = 0;
+}
+
+MappedTempFile& MappedTempFile::operator=(MappedTempFile&& other)
+{
+   if (this != &other) {
+      release();
+      std::swap(m_data, other.m_data);
+      std::swap(m_size, other.m_size);
+   }
+   return *this;
+}
+
+MappedTempFile::~MappedTempFile()
+{ release(); }
+
+void MappedTempFile::release()
+{
+   if (m_data)
+      ::munmap(m_data, m_size);
+   m_data = nullptr;
+   m_size = 0;
+}
+
+void MappedTempFile::advise(MappedFile::Access access, size_t offset, size_t length) const
+{ PolLatBuilder::advise(m_data, m_size, access, offset, length); }
+
+}
@@ -0,0 +1,90 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PolLatbuilder/ModularPoly.h"
+
+#include <stdexcept>
+
+namespace PolLatBuilder {
+
+namespace {
+   void checkModulus(const ModularPoly& a, const ModularPoly& b)
+   {
+      if (not a.modulus() or not ModularPoly::sameModulus(a, b))
+         throw std::runtime_error("ModularPoly: operands have different moduli");
+   }
+}
+
+//================================================================================
+
+PolyModulus::PolyModulus(Poly polynomial):
+   m_polynomial(std::move(polynomial))
+{
+   if (deg(m_polynomial) < 1)
+      throw std::runtime_error("PolyModulus: the modulus must have a positive degree");
+   build(m_reducer, m_polynomial);
+}
+
+//================================================================================
+
+ModularPoly::ModularPoly(ModulusPtr modulus, const Poly& value):
+   m_modulus(std::move(modulus))
+{
+   if (not m_modulus)
+      throw std::runtime_error("ModularPoly: null modulus");
+   rem(m_rep, value, m_modulus->reducer());
+}
+
+ModularPoly& ModularPoly::operator+=(const ModularPoly& other)
+{
+   checkModulus(*this, other);
+   add(m_rep, m_rep, other.m_rep);
+   return *this;
+}
+
+ModularPoly& ModularPoly::operator*=(const ModularPoly& other)
+{
+   checkModulus(*this, other);
+   MulMod(m_rep, m_rep, other.m_rep, m_modulus->reducer());
+   return *this;
+}
+
+ModularPoly inv(const ModularPoly& x)
+{
+   if (not x.modulus())
+      throw std::runtime_error("ModularPoly: null modulus");
+   Poly d, s, t;
+   XGCD(d, s, t, rep(x), x.modulus()->polynomial());
+   if (not IsOne(d))
+      throw std::runtime_error("ModularPoly: value is not invertible");
+   return ModularPoly(x.modulus(), s);
+}
+
+ModularPoly power(const ModularPoly& x, long e)
+{
+   if (not x.modulus())
+      throw std::runtime_error("ModularPoly: null modulus");
+   if (e < 0)
+      return power(inv(x), -e);
+   Poly r;
+   PowerMod(r, rep(x), e, x.modulus()->reducer());
+   return ModularPoly::fromReduced(x.modulus(), std::move(r));
+}
+
+std::ostream& operator<<(std::ostream& os, const ModularPoly& x)
+{ return os << rep(x); }
+
+}
@@ -0,0 +1,301 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PolLatbuilder/Kernel/NuTable.h"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define POLLATBUILDER__X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace PolLatBuilder { namespace Kernel {
+
+namespace {
+
+void evaluateGeneric(const Real* table, const uint64_t* digits, size_t n, Real* out)
+{
+   for (size_t i = 0; i < n; i++)
+      out[i] = table[leadingZeros(digits[i])];
+}
+
+Real dotGeneric(const Real* table, const uint64_t* digits, const Real* weights, size_t n)
+{
+   Real sum = 0.0;
+   for (size_t i = 0; i < n; i++)
+      sum += weights[i] * table[leadingZeros(digits[i])];
+   return sum;
+}
+
+
+/**
+ * Kernel values for the bit-sliced evaluation: the value for \f$\nu = 1\f$,
+ * common to about half of the point sets at each point, and the differences
+ * with that value for the other positions, indexed by digit bit, and for the
+ * origin.
+ */
+struct BitSlicedValues {
+   explicit BitSlicedValues(const NuTable& table)
+   {
+      const unsigned m = table.numDigits();
+      const Real* values = table.data();
+      base = values[64 - m];
+      for (unsigned r = 0; r < m; r++)
+         delta[r] = values[63 - r] - base;
+      deltaZero = values[64] - base;
+   }
+
+   Real base;
+   Real delta[NuTable::maxBitSlicedDigits()];
+   Real deltaZero;
+};
+
+void bitSlicedDotGeneric(
+      const NuTable& table, const uint64_t* slices, uint64_t sets, uint64_t* x,
+      size_t first, const Real* weights, size_t count, Real* sums)
+{
+   const unsigned m = table.numDigits();
+   const BitSlicedValues values(table);
+   Real acc[64] = {};
+   Real total = 0.0;
+
+   for (size_t t = 0; t < count; t++) {
+      const size_t i = first + t;
+      if (i > 0) {
+         const uint64_t* s = slices + trailingZeros(i) * NuTable::maxBitSlicedDigits();
+         for (unsigned r = 0; r < m; r++)
+            x[r] ^= s[r];
+      }
+      const Real w = weights[t];
+      total += w;
+      // resolve the point sets one digit at a time, from the first one
+      uint64_t seen = x[m - 1] & sets;
+      for (unsigned r = m - 1; r-- > 0 and seen != sets; ) {
+         uint64_t newly = x[r] & sets & ~seen;
+         if (newly) {
+            seen |= newly;
+            const Real v = w * values.delta[r];
+            for (; newly; newly &= newly - 1)
+               acc[trailingZeros(newly)] += v;
+         }
+      }
+      if (seen != sets) {
+         const Real v = w * values.deltaZero;
+         for (uint64_t rest = sets & ~seen; rest; rest &= rest - 1)
+            acc[trailingZeros(rest)] += v;
+      }
+   }
+
+   for (uint64_t c = sets; c; c &= c - 1)
+      sums[trailingZeros(c)] += acc[trailingZeros(c)] + values.base * total;
+}
+
+#ifdef POLLATBUILDER__X86_DISPATCH
+
+//================================================================================
+// AVX-512
+
+__attribute__((target("avx512f,avx512cd")))
+void evaluateAVX512(const Real* table, const uint64_t* digits, size_t n, Real* out)
+{
+   size_t i = 0;
+   for (; i + 8 <= n; i += 8) {
+      const __m512i idx = _mm512_lzcnt_epi64(_mm512_loadu_si512(digits + i));
+      _mm512_storeu_pd(out + i, _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xff, idx, table, 8));
+   }
+   evaluateGeneric(table, digits + i, n - i, out + i);
+}
+
+__attribute__((target("avx512f,avx512cd")))
+Real dotAVX512(const Real* table, const uint64_t* digits, const Real* weights, size_t n)
+{
+   __m512d acc0 = _mm512_setzero_pd();
+   __m512d acc1 = _mm512_setzero_pd();
+   size_t i = 0;
+   for (; i + 16 <= n; i += 16) {
+      const __m512i idx0 = _mm512_lzcnt_epi64(_mm512_loadu_si512(digits + i));
+      const __m512i idx1 = _mm512_lzcnt_epi64(_mm512_loadu_si512(digits + i + 8));
+      acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(weights + i), _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xff, idx0, table, 8), acc0);
+      acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(weights + i + 8), _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xff, idx1, table, 8), acc1);
+   }
+   for (; i + 8 <= n; i += 8) {
+      const __m512i idx = _mm512_lzcnt_epi64(_mm512_loadu_si512(digits + i));
+      acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(weights + i), _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xff, idx, table, 8), acc0);
+   }
+   alignas(64) Real lanes[8];
+   _mm512_store_pd(lanes, _mm512_add_pd(acc0, acc1));
+   return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]))
+      + dotGeneric(table, digits + i, weights + i, n - i);
+}
+
+/**
+ * Adds \c v to the lanes of \c acc0 to \c acc7 selected by the bits of
+ * \c mask.
+ */
+#define POLLATBUILDER__MASK_ADD(mask, v) \
+   do { \
+      acc0 = _mm512_mask_add_pd(acc0, __mmask8(mask), acc0, v); \
+      acc1 = _mm512_mask_add_pd(acc1, __mmask8(mask >> 8), acc1, v); \
+      acc2 = _mm512_mask_add_pd(acc2, __mmask8(mask >> 16), acc2, v); \
+      acc3 = _mm512_mask_add_pd(acc3, __mmask8(mask >> 24), acc3, v); \
+      acc4 = _mm512_mask_add_pd(acc4, __mmask8(mask >> 32), acc4, v); \
+      acc5 = _mm512_mask_add_pd(acc5, __mmask8(mask >> 40), acc5, v); \
+      acc6 = _mm512_mask_add_pd(acc6, __mmask8(mask >> 48), acc6, v); \
+      acc7 = _mm512_mask_add_pd(acc7, __mmask8(mask >> 56), acc7, v); \
+   } while (0)
+
+/**
+ * The sums of the 64 point sets are kept in 8 vector registers and each digit
+ * position updates them with masked additions instead of one addition per
+ * point set.
+ */
+__attribute__((target("avx512f,avx512cd")))
+void bitSlicedDotAVX512(
+      const NuTable& table, const uint64_t* slices, uint64_t sets, uint64_t* state,
+      size_t first, const Real* weights, size_t count, Real* sums)
+{
+   const unsigned m = table.numDigits();
+   const BitSlicedValues values(table);
+   __m512d acc0 = _mm512_setzero_pd(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+   __m512d acc4 = acc0, acc5 = acc0, acc6 = acc0, acc7 = acc0;
+   Real total = 0.0;
+   // the state is held in four vector registers
+   alignas(64) uint64_t x[NuTable::maxBitSlicedDigits()] = {};
+   std::copy(state, state + m, x);
+   __m512i x0 = _mm512_load_si512(x), x1 = _mm512_load_si512(x + 8);
+   __m512i x2 = _mm512_load_si512(x + 16), x3 = _mm512_load_si512(x + 24);
+
+   for (size_t t = 0; t < count; t++) {
+      const size_t i = first + t;
+      if (i > 0) {
+         const uint64_t* s = slices + trailingZeros(i) * NuTable::maxBitSlicedDigits();
+         x0 = _mm512_xor_si512(x0, _mm512_loadu_si512(s));
+         x1 = _mm512_xor_si512(x1, _mm512_loadu_si512(s + 8));
+         x2 = _mm512_xor_si512(x2, _mm512_loadu_si512(s + 16));
+         x3 = _mm512_xor_si512(x3, _mm512_loadu_si512(s + 24));
+         _mm512_store_si512(x, x0);
+         _mm512_store_si512(x + 8, x1);
+         _mm512_store_si512(x + 16, x2);
+         _mm512_store_si512(x + 24, x3);
+      }
+      const Real w = weights[t];
+      total += w;
+      uint64_t seen = x[m - 1] & sets;
+      for (unsigned r = m - 1; r-- > 0 and seen != sets; ) {
+         const uint64_t newly = x[r] & sets & ~seen;
+         seen |= newly;
+         const __m512d v = _mm512_set1_pd(w * values.delta[r]);
+         POLLATBUILDER__MASK_ADD(newly, v);
+      }
+      const uint64_t rest = sets & ~seen;
+      const __m512d v = _mm512_set1_pd(w * values.deltaZero);
+      POLLATBUILDER__MASK_ADD(rest, v);
+   }
+   std::copy(x, x + m, state);
+
+   alignas(64) Real lanes[64];
+   _mm512_store_pd(lanes, acc0);
+   _mm512_store_pd(lanes + 8, acc1);
+   _mm512_store_pd(lanes + 16, acc2);
+   _mm512_store_pd(lanes + 24, acc3);
+   _mm512_store_pd(lanes + 32, acc4);
+   _mm512_store_pd(lanes + 40, acc5);
+   _mm512_store_pd(lanes + 48, acc6);
+   _mm512_store_pd(lanes + 56, acc7);
+   for (uint64_t c = sets; c; c &= c - 1)
+      sums[trailingZeros(c)] += lanes[trailingZeros(c)] + values.base * total;
+}
+
+#undef POLLATBUILDER__MASK_ADD
+
+//================================================================================
+// AVX2
+
+/**
+ * Returns the leading-zero counts of four words smaller than \f$2^{52}\f$.
+ *
+ * Each word \f$x\f$ is converted exactly to floating point as \f$(2^{52} + x)
+ * - 2^{52}\f$, whose biased exponent is \f$1023 + 63 - \mathrm{clz}(x)\f$ if
+ * \f$x \neq 0\f$.
+ */
+__attribute__((target("avx2,fma")))
+inline __m256i leadingZerosAVX2(__m256i x)
+{
+   const __m256d magic = _mm256_set1_pd(4503599627370496.0);
+   const __m256d d = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(x, _mm256_castpd_si256(magic))), magic);
+   const __m256i idx = _mm256_sub_epi64(_mm256_set1_epi64x(1086), _mm256_srli_epi64(_mm256_castpd_si256(d), 52));
+   const __m256i zero = _mm256_cmpeq_epi64(x, _mm256_setzero_si256());
+   return _mm256_blendv_epi8(idx, _mm256_set1_epi64x(64), zero);
+}
+
+__attribute__((target("avx2,fma")))
+void evaluateAVX2(const Real* table, const uint64_t* digits, size_t n, Real* out)
+{
+   size_t i = 0;
+   for (; i + 4 <= n; i += 4) {
+      const __m256i idx = leadingZerosAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(digits + i)));
+      _mm256_storeu_pd(out + i, _mm256_i64gather_pd(table, idx, 8));
+   }
+   evaluateGeneric(table, digits + i, n - i, out + i);
+}
+
+__attribute__((target("avx2,fma")))
+Real dotAVX2(const Real* table, const uint64_t* digits, const Real* weights, size_t n)
+{
+   __m256d acc0 = _mm256_setzero_pd();
+   __m256d acc1 = _mm256_setzero_pd();
+   size_t i = 0;
+   for (; i + 8 <= n; i += 8) {
+      const __m256i idx0 = leadingZerosAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(digits + i)));
+      const __m256i idx1 = leadingZerosAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(digits + i + 4)));
+      acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(weights + i), _mm256_i64gather_pd(table, idx0, 8), acc0);
+      acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(weights + i + 4), _mm256_i64gather_pd(table, idx1, 8), acc1);
+   }
+   alignas(32) Real lanes[4];
+   _mm256_store_pd(lanes, _mm256_add_pd(acc0, acc1));
+   return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + dotGeneric(table, digits + i, weights + i, n - i);
+}
+
+#endif
+
+}
+
+void NuTable::init()
+{
+   m_evaluate = evaluateGeneric;
+   m_dot = dotGeneric;
+   m_bitSlicedDot = bitSlicedDotGeneric;
+   m_bitSlicedVectorized = false;
+   m_instructionSet = "generic";
+#ifdef POLLATBUILDER__X86_DISPATCH
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx512f") and __builtin_cpu_supports("avx512cd")) {
+      m_evaluate = evaluateAVX512;
+      m_dot = dotAVX512;
+      m_bitSlicedDot = bitSlicedDotAVX512;
+      m_bitSlicedVectorized = true;
+      m_instructionSet = "avx512";
+   }
+   else if (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("fma") and m_numDigits <= 52) {
+      m_evaluate = evaluateAVX2;
+      m_dot = dotAVX2;
+      m_instructionSet = "avx2";
+   }
+#endif
+}
+
+}}
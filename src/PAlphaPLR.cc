@@ -0,0 +1,37 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PolLatbuilder/Kernel/PAlphaPLR.h"
+
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace PolLatBuilder { namespace Kernel {
+
+std::shared_ptr<const NuTable> PAlphaPLR::table(unsigned numDigits) const
+{
+   static std::mutex mutex;
+   static std::map<std::pair<unsigned, Real>, std::shared_ptr<const NuTable>> tables;
+
+   std::lock_guard<std::mutex> lock(mutex);
+   auto& table = tables[std::make_pair(numDigits, m_alpha)];
+   if (not table)
+      table = std::make_shared<NuTable>(*this, numDigits);
+   return table;
+}
+
+}}
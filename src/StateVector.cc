@@ -0,0 +1,240 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PolLatbuilder/MeritSeq/StateVector.h"
+
+#include <cstring>
+
+#include <unistd.h>
+
+namespace PolLatBuilder { namespace MeritSeq {
+
+namespace {
+   /**
+    * Returns the size of the largest data cache in bytes, or 0 if it is
+    * unknown.
+    */
+   size_t lastLevelCacheSize()
+   {
+      long size = 0;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+      size = ::sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+#ifdef _SC_LEVEL2_CACHE_SIZE
+      if (size <= 0)
+         size = ::sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+      return size > 0 ? size_t(size) : 0;
+   }
+
+   template <typename T, typename U>
+   void convert(const T* x, U* y, Modulus size)
+   {
+      for (Modulus i = 0; i < size; i++)
+         y[i] = U(x[i]);
+   }
+
+   Real roundingError(const Real* exact, const float* stored, Modulus size)
+   {
+      Real error = 0.0;
+      for (Modulus i = 0; i < size; i++)
+         error = std::max(error, std::abs(Real(stored[i]) - exact[i]));
+      return error;
+   }
+}
+
+//================================================================================
+// StateStorage
+//================================================================================
+
+size_t StateStorage::defaultChunkBytes()
+{
+   static const size_t bytes = [] {
+      const size_t page = ::sysconf(_SC_PAGESIZE);
+      size_t cache = lastLevelCacheSize();
+      if (cache == 0)
+         cache = size_t(8) << 20;
+      return std::max(page, cache / 2 / page * page);
+   }();
+   return bytes;
+}
+
+//================================================================================
+// StateVector
+//================================================================================
+
+StateVector::StateVector(const Real* first, const Real* last, const StateStorage& storage):
+   StateVector(storage)
+{
+   const Modulus size = last - first;
+   allocate(size);
+   const Modulus chunk = chunkSize();
+   for (Modulus begin = 0; begin < size; begin += chunk) {
+      const Modulus count = std::min(chunk, size - begin);
+      prefetch(begin, count);
+      if (precision() == Precision::SINGLE) {
+         float* x = static_cast<float*>(m_data) + begin;
+         convert(first + begin, x, count);
+         m_error = std::max(m_error, roundingError(first + begin, x, count));
+      }
+      else
+         std::memcpy(data() + begin, first + begin, count * sizeof(Real));
+   }
+}
+
+StateVector::StateVector(const StateVector& other):
+   StateVector(other.m_storage)
+{ *this = other; }
+
+StateVector& StateVector::operator=(const StateVector& other)
+{
+   if (this == &other)
+      return *this;
+   m_storage = other.m_storage;
+   allocate(other.m_size);
+   const Modulus chunk = chunkSize();
+   for (Modulus begin = 0; begin < m_size; begin += chunk) {
+      const Modulus count = std::min(chunk, m_size - begin);
+      other.prefetch(begin, count);
+      prefetch(begin, count);
+      std::memcpy(static_cast<char*>(m_data) + begin * elementSize(),
+            static_cast<const char*>(other.m_data) + begin * elementSize(),
+            count * elementSize());
+   }
+   m_error = other.m_error;
+   return *this;
+}
+
+StateVector::StateVector(StateVector&& other):
+   m_storage(std::move(other.m_storage)),
+   m_size(other.m_size),
+   m_memory(std::move(other.m_memory)),
+   m_mapping(std::move(other.m_mapping)),
+   m_data(other.m_data),
+   m_allocated(other.m_allocated),
+   m_error(other.m_error)
+{
+   other.m_size = 0;
+   other.m_data = nullptr;
+}
+
+StateVector& StateVector::operator=(StateVector&& other)
+{
+   if (this != &other) {
+      m_storage = std::move(other.m_storage);
+      m_size = other.m_size;
+      m_memory = std::move(other.m_memory);
+      m_mapping = std::move(other.m_mapping);
+      m_data = other.m_data;
+      m_allocated = other.m_allocated;
+      m_error = other.m_error;
+      other.m_size = 0;
+      other.m_data = nullptr;
+   }
+   return *this;
+}
+
+void StateVector::assign(Modulus size, Real value)
+{
+   const bool zero = allocate(size) and m_mapping;
+   m_error = 0.0;
+   if (precision() == Precision::SINGLE) {
+      if (size)
+         m_error = std::abs(Real(float(value)) - value);
+   }
+   // new mapped vectors are already zero-filled
+   if (value == 0.0 and zero)
+      return;
+   transform([value](Modulus, Real) { return value; });
+}
+
+void StateVector::clear()
+{ allocate(0); }
+
+RealVector StateVector::toReal() const
+{
+   RealVector x(m_size);
+   const Modulus chunk = chunkSize();
+   for (Modulus begin = 0; begin < m_size; begin += chunk) {
+      const Modulus count = std::min(chunk, m_size - begin);
+      const Real* y = block(begin, count, x.data() + begin);
+      if (y != x.data() + begin)
+         std::memcpy(x.data() + begin, y, count * sizeof(Real));
+   }
+   return x;
+}
+
+void StateVector::setPrecision(Precision precision)
+{
+   if (precision == this->precision())
+      return;
+   StateStorage storage = m_storage;
+   storage.precision = precision;
+   StateVector converted(storage);
+   converted.allocate(m_size);
+   const Modulus chunk = std::min(chunkSize(), converted.chunkSize());
+   for (Modulus begin = 0; begin < m_size; begin += chunk) {
+      const Modulus count = std::min(chunk, m_size - begin);
+      prefetch(begin, count);
+      converted.prefetch(begin, count);
+      if (precision == Precision::SINGLE) {
+         float* y = static_cast<float*>(converted.m_data) + begin;
+         convert(data() + begin, y, count);
+         converted.m_error = std::max(converted.m_error, roundingError(data() + begin, y, count));
+      }
+      else
+         convert(static_cast<const float*>(m_data) + begin, converted.data() + begin, count);
+   }
+   converted.m_error += m_error;
+   *this = std::move(converted);
+}
+
+Modulus StateVector::chunkSize() const
+{
+   if (not m_storage.isMapped())
+      return std::max<Modulus>(m_size, 1);
+   const size_t bytes = m_storage.chunkBytes ? m_storage.chunkBytes : StateStorage::defaultChunkBytes();
+   return std::max<Modulus>(bytes / elementSize(), 1);
+}
+
+bool StateVector::allocate(Modulus size)
+{
+   // the space is reused if it has the right size
+   const size_t bytes = size * elementSize();
+   if (size > 0 and m_data and m_allocated == bytes and bool(m_mapping) == m_storage.isMapped()) {
+      m_size = size;
+      return false;
+   }
+   m_memory.reset();
+   m_mapping.reset();
+   m_data = nullptr;
+   m_size = size;
+   m_allocated = bytes;
+   if (size == 0)
+      return true;
+   if (m_storage.isMapped()) {
+      m_mapping.reset(new MappedTempFile(m_storage.directory, bytes));
+      m_mapping->advise(MappedFile::Access::SEQUENTIAL);
+      m_data = m_mapping->data();
+   }
+   else {
+      m_memory.reset(new char[bytes]);
+      m_data = m_memory.get();
+   }
+   return true;
+}
+
+}}
@@ -0,0 +1,361 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PolLatbuilder/TValue.h"
+#include "PolLatbuilder/Util.h"
+#include "PolLatbuilder/Parallel/BlockCursor.h"
+
+#include <array>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+
+namespace PolLatBuilder {
+
+namespace {
+
+//================================================================================
+
+/**
+ * Calls \c worker on \c numThreads threads, including the calling thread.
+ *
+ * If a call throws, the first exception is rethrown once all threads have
+ * finished; \c failed is set so that the other workers can stop early.
+ */
+template <class WORKER>
+void runWorkers(unsigned numThreads, std::atomic<bool>& failed, const WORKER& worker)
+{
+   std::exception_ptr error;
+   std::mutex mutex;
+   auto guarded = [&]() {
+      try {
+         worker();
+      }
+      catch (...) {
+         std::lock_guard<std::mutex> lock(mutex);
+         if (not error)
+            error = std::current_exception();
+         failed.store(true, std::memory_order_relaxed);
+      }
+   };
+   std::vector<std::thread> threads;
+   for (unsigned i = 1; i < numThreads; i++)
+      threads.emplace_back(guarded);
+   guarded();
+   for (auto& t : threads)
+      t.join();
+   if (error)
+      std::rethrow_exception(error);
+}
+
+//================================================================================
+
+/**
+ * Echelon basis of GF(2) row vectors supporting removal in reverse order of
+ * insertion.
+ *
+ * Each basis vector is stored at the index of its leading bit and is never
+ * modified after its insertion, so removing the last inserted vectors
+ * restores the previous state exactly.
+ */
+class EchelonBasis {
+public:
+   EchelonBasis(): m_size(0)
+   { m_basis.fill(0); }
+
+   /**
+    * Adds \c v to the basis.  Returns \c false, leaving the basis unchanged,
+    * if \c v is a linear combination of the basis vectors.
+    */
+   bool add(uint64_t v)
+   {
+      while (v) {
+         const unsigned p = 63 - leadingZeros(v);
+         if (!m_basis[p]) {
+            m_basis[p] = v;
+            m_pivots[m_size++] = p;
+            return true;
+         }
+         v ^= m_basis[p];
+      }
+      return false;
+   }
+
+   /**
+    * Removes the \c count last inserted vectors.
+    */
+   void pop(unsigned count)
+   {
+      while (count--)
+         m_basis[m_pivots[--m_size]] = 0;
+   }
+
+private:
+   std::array<uint64_t, 64> m_basis;
+   std::array<unsigned char, 64> m_pivots;
+   unsigned m_size;
+};
+
+//================================================================================
+
+/**
+ * Test of the linear independence of the rows selected by all compositions of
+ * a given strength.
+ */
+class StrengthTest {
+public:
+   StrengthTest(const std::vector<GeneratingMatrix>& mats, const std::vector<Dimension>& coords)
+   {
+      m_rows.reserve(coords.size());
+      for (const auto j : coords)
+         m_rows.push_back(mats[j].rows());
+   }
+
+   /**
+    * Returns \c true if the rows are independent for all compositions of
+    * \c strength.
+    */
+   bool operator()(unsigned strength, unsigned numThreads) const
+   {
+      const Dimension s = m_rows.size();
+      if (s == 0 or strength == 0)
+         return true;
+
+      // the compositions are split into tasks according to the number of
+      // rows taken from the first coordinate, and from the second one if there
+      // are more than two
+      std::vector<std::pair<unsigned, unsigned>> tasks;
+      if (s == 1)
+         tasks.emplace_back(strength, 0);
+      else if (s == 2) {
+         for (unsigned d0 = 0; d0 <= strength; d0++)
+            tasks.emplace_back(d0, strength - d0);
+      }
+      else {
+         for (unsigned d0 = 0; d0 <= strength; d0++)
+            for (unsigned d1 = 0; d0 + d1 <= strength; d1++)
+               tasks.emplace_back(d0, d1);
+      }
+      const Dimension head = std::min<Dimension>(s, 2);
+
+      std::atomic<bool> failed(false);
+      Parallel::BlockCursor cursor(tasks.size(), 1);
+
+      auto worker = [&]() {
+         size_t first, count;
+         EchelonBasis basis;
+         while (not failed.load(std::memory_order_relaxed) and cursor.next(first, count)) {
+            const auto& task = tasks[first];
+            unsigned added = 0;
+            bool ok = addRows(basis, 0, task.first, added);
+            if (ok and s > 1)
+               ok = addRows(basis, 1, task.second, added);
+            if (ok)
+               ok = test(basis, head, strength - task.first - task.second, failed);
+            basis.pop(added);
+            if (not ok)
+               failed.store(true, std::memory_order_relaxed);
+         }
+      };
+
+      runWorkers(std::max(1u, std::min<unsigned>(numThreads, tasks.size())), failed, worker);
+
+      return not failed.load();
+   }
+
+private:
+   std::vector<std::vector<uint64_t>> m_rows;
+
+   /**
+    * Adds the first \c count rows of coordinate \c j to \c basis and
+    * increments \c added by the number of rows added.
+    */
+   bool addRows(EchelonBasis& basis, Dimension j, unsigned count, unsigned& added) const
+   {
+      const auto& rows = m_rows[j];
+      if (count > rows.size())
+         return false;
+      for (unsigned r = 0; r < count; r++) {
+         if (not basis.add(rows[r]))
+            return false;
+         added++;
+      }
+      return true;
+   }
+
+   /**
+    * Depth-first test of all compositions of \c remaining over coordinates
+    * \c j and above, on top of the rows already in \c basis.
+    */
+   bool test(EchelonBasis& basis, Dimension j, unsigned remaining, const std::atomic<bool>& failed) const
+   {
+      if (remaining == 0)
+         return true;
+
+      unsigned added = 0;
+      if (j + 1 == m_rows.size()) {
+         const bool ok = addRows(basis, j, remaining, added);
+         basis.pop(added);
+         return ok;
+      }
+
+      if (failed.load(std::memory_order_relaxed))
+         return false;
+
+      const auto& rows = m_rows[j];
+      bool ok = true;
+      for (unsigned d = 0; ok; d++) {
+         ok = test(basis, j + 1, remaining - d, failed);
+         if (not ok or d == remaining)
+            break;
+         // take one more row from this coordinate
+         if (d >= rows.size() or not basis.add(rows[d]))
+            ok = false;
+         else
+            added++;
+      }
+      basis.pop(added);
+      return ok;
+   }
+};
+
+//================================================================================
+
+unsigned defaultThreads(unsigned numThreads)
+{
+   if (numThreads == 0)
+      numThreads = std::thread::hardware_concurrency();
+   return std::max(1u, numThreads);
+}
+
+unsigned numColumns(const std::vector<GeneratingMatrix>& mats, const std::vector<Dimension>& coords)
+{
+   if (coords.empty())
+      return 0;
+   const auto m = mats[coords.front()].size2();
+   for (const auto j : coords) {
+      if (mats[j].size2() != m)
+         throw std::runtime_error("tValue: generating matrices must have the same number of columns");
+   }
+   return m;
+}
+
+}
+
+//================================================================================
+
+unsigned tValue(
+      const std::vector<GeneratingMatrix>& mats,
+      const std::vector<Dimension>& coords,
+      unsigned numThreads,
+      unsigned lowerBound)
+{
+   const unsigned m = numColumns(mats, coords);
+   numThreads = defaultThreads(numThreads);
+   const StrengthTest test(mats, coords);
+   // the strength is the largest value that passes the test; failures are
+   // usually detected early, so search downwards
+   for (unsigned strength = m - std::min(lowerBound, m); strength > 0; strength--) {
+      if (test(strength, numThreads))
+         return m - strength;
+   }
+   return m;
+}
+
+unsigned tValue(
+      const std::vector<GeneratingMatrix>& mats,
+      unsigned numThreads,
+      unsigned lowerBound)
+{
+   std::vector<Dimension> coords(mats.size());
+   for (Dimension j = 0; j < coords.size(); j++)
+      coords[j] = j;
+   return tValue(mats, coords, numThreads, lowerBound);
+}
+
+//================================================================================
+
+std::vector<ProjectionTValue> projectionTValues(
+      const std::vector<GeneratingMatrix>& mats,
+      Dimension maxOrder,
+      unsigned numThreads)
+{
+   const Dimension s = mats.size();
+   maxOrder = std::min(maxOrder, s);
+   numThreads = defaultThreads(numThreads);
+   for (const auto& mat : mats) {
+      if (mat.size2() != mats.front().size2())
+         throw std::runtime_error("projectionTValues: generating matrices must have the same number of columns");
+   }
+
+   std::vector<ProjectionTValue> result;
+   std::map<std::vector<Dimension>, unsigned> previous;
+
+   for (Dimension order = 1; order <= maxOrder; order++) {
+
+      // enumerate projections of this order in lexicographic order
+      std::vector<ProjectionTValue> projs;
+      std::vector<Dimension> coords(order);
+      for (Dimension i = 0; i < order; i++)
+         coords[i] = i;
+      while (true) {
+         projs.push_back(ProjectionTValue{coords, 0});
+         Dimension i = order;
+         while (i > 0 and coords[i - 1] == s - order + i - 1)
+            i--;
+         if (i == 0)
+            break;
+         coords[i - 1]++;
+         for (Dimension k = i; k < order; k++)
+            coords[k] = coords[k - 1] + 1;
+      }
+
+      Parallel::BlockCursor cursor(projs.size(), 1);
+      std::atomic<bool> failed(false);
+      auto worker = [&]() {
+         size_t first, count;
+         while (not failed.load(std::memory_order_relaxed) and cursor.next(first, count)) {
+            auto& proj = projs[first];
+            // t-values can only grow with the projection
+            unsigned bound = 0;
+            if (order > 1) {
+               std::vector<Dimension> sub(order - 1);
+               for (Dimension k = 0; k < order; k++) {
+                  std::copy(proj.coordinates.begin(), proj.coordinates.begin() + k, sub.begin());
+                  std::copy(proj.coordinates.begin() + k + 1, proj.coordinates.end(), sub.begin() + k);
+                  bound = std::max(bound, previous.at(sub));
+               }
+            }
+            proj.tValue = tValue(mats, proj.coordinates, 1, bound);
+         }
+      };
+
+      runWorkers(std::min<size_t>(numThreads, projs.size()), failed, worker);
+
+      previous.clear();
+      for (const auto& proj : projs)
+         previous[proj.coordinates] = proj.tValue;
+      result.insert(result.end(), projs.begin(), projs.end());
+   }
+
+   return result;
+}
+
+}
@@ -0,0 +1,87 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PolLatbuilder/TraversalSchedule.h"
+
+#include <algorithm>
+#include <ostream>
+
+namespace PolLatBuilder {
+
+TraversalSchedule TraversalSchedule::budgeted(
+      Dimension dimension,
+      size_t numCandidates,
+      uint64_t budget,
+      CoordinateTraversal::Kind later,
+      size_t minSize)
+{
+   if (dimension == 0)
+      return TraversalSchedule();
+   if (later == CoordinateTraversal::Kind::FORWARD)
+      throw std::runtime_error("TraversalSchedule: the later coordinates must be subsampled");
+   minSize = std::max<size_t>(1, std::min(minSize, numCandidates));
+
+   std::vector<CoordinateTraversal> travs;
+   Dimension j = 0;
+   // exhaustive search while the other coordinates can still get minSize
+   // candidates each
+   for (; j < dimension; j++) {
+      const uint64_t reserved = uint64_t(dimension - j - 1) * minSize;
+      if (numCandidates > budget or budget - numCandidates < reserved)
+         break;
+      travs.push_back(CoordinateTraversal::forward());
+      budget -= numCandidates;
+   }
+   // even split of the rest
+   for (Dimension left = dimension - j; j < dimension; j++, left--) {
+      const size_t size = std::max<uint64_t>(minSize, std::min<uint64_t>(budget / left, numCandidates));
+      travs.push_back(size == numCandidates and later == CoordinateTraversal::Kind::STRATIFIED ?
+            CoordinateTraversal::forward() : CoordinateTraversal{later, size});
+      budget -= std::min<uint64_t>(budget, size);
+   }
+   return TraversalSchedule(std::move(travs));
+}
+
+uint64_t TraversalSchedule::cost(Dimension dimension, size_t numCandidates) const
+{
+   uint64_t total = 0;
+   for (Dimension j = 0; j < dimension; j++)
+      total += (*this)[j].cost(numCandidates);
+   return total;
+}
+
+std::ostream& operator<<(std::ostream& os, const CoordinateTraversal& trav)
+{
+   switch (trav.kind) {
+   case CoordinateTraversal::Kind::FORWARD:
+      return os << "forward";
+   case CoordinateTraversal::Kind::RANDOM:
+      return os << "random(" << trav.size << ")";
+   case CoordinateTraversal::Kind::STRATIFIED:
+      return os << "stratified(" << trav.size << ")";
+   }
+   return os;
+}
+
+std::ostream& operator<<(std::ostream& os, const TraversalSchedule& schedule)
+{
+   const auto& travs = schedule.traversals();
+   for (size_t j = 0; j < travs.size(); j++)
+      os << (j ? ", " : "") << travs[j];
+   return os;
+}
+
+}
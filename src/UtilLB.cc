@@ -17,6 +17,7 @@
 #include "PolLatbuilder/Util.h"
 #include <cmath>
 #include <cstdlib>
+#include <stdexcept>
 
 namespace PolLatBuilder
 {
@@ -33,6 +34,58 @@ Poly intToPoly(Modulus x)
    }
     return P;
 }
+
+//================================================================================
+
+Modulus polyToInt(const Poly& P)
+{
+   if (deg(P) >= 64)
+      throw std::runtime_error("polyToInt: polynomial degree must be < 64");
+   Modulus x = 0;
+   for (long i = deg(P); i >= 0; i--)
+      x = (x << 1) | Modulus(IsOne(coeff(P, i)));
+   return x;
+}
+
+//================================================================================
+
+std::vector<uint64_t> laurentColumns(Modulus g, Modulus P, unsigned numRows, unsigned numCols)
+{
+   if (P <= 1)
+      throw std::runtime_error("laurentColumns: modulus degree must be in 1..63");
+   if (numRows == 0 or numRows > 64)
+      throw std::runtime_error("laurentColumns: number of rows must be in 1..64");
+
+   const unsigned m = 63 - leadingZeros(P);
+   const uint64_t top = uint64_t(1) << m;
+   const uint64_t mask = numRows == 64 ? ~uint64_t(0) : (uint64_t(1) << numRows) - 1;
+
+   // one step of long division of r/P: returns the next Laurent coefficient
+   uint64_t r = g;
+   auto next = [&]() -> uint64_t {
+      r <<= 1;
+      if (r & top) {
+         r ^= P;
+         return 1;
+      }
+      return 0;
+   };
+
+   std::vector<uint64_t> cols(numCols);
+   if (numCols == 0)
+      return cols;
+
+   uint64_t col = 0;
+   for (unsigned l = 0; l < numRows; l++)
+      col = (col << 1) | next();
+   cols[0] = col;
+   for (unsigned s = 1; s < numCols; s++) {
+      col = ((col << 1) | next()) & mask;
+      cols[s] = col;
+   }
+   return cols;
+}
+
 //================================================================================
 
 Modulus modularPow(Modulus base, Modulus exponent, Modulus modulus)
@@ -0,0 +1,154 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PolLatbuilder/WalshMerit.h"
+#include "PolLatbuilder/FWHT.h"
+#include "PolLatbuilder/Util.h"
+#include "PolLatbuilder/Parallel/BlockCursor.h"
+
+#include <thread>
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+
+namespace PolLatBuilder {
+
+WalshMerit::WalshMerit(unsigned numDigits, RealVector coefficients):
+   m_numDigits(numDigits),
+   m_coefficients(std::move(coefficients))
+{
+   if (m_numDigits < 1 or m_numDigits > 30)
+      throw std::runtime_error("WalshMerit: number of digits must be in 1..30");
+   if (m_coefficients.size() != numPoints())
+      throw std::runtime_error("WalshMerit: there must be one coefficient per point");
+}
+
+WalshMerit::WalshMerit(const Kernel::NuTable& table):
+   m_numDigits(table.numDigits())
+{
+   if (m_numDigits < 1 or m_numDigits > 30)
+      throw std::runtime_error("WalshMerit: number of digits must be in 1..30");
+   const Modulus n = numPoints();
+   m_coefficients.resize(n);
+   for (Modulus x = 0; x < n; x++)
+      m_coefficients[x] = table(x);
+   fwht(m_coefficients);
+   for (auto& c : m_coefficients)
+      c /= Real(n);
+}
+
+void WalshMerit::indicatorVector(const GeneratingMatrix& mat, Real weight, Real* out) const
+{
+   if (mat.size1() != m_numDigits or mat.size2() != m_numDigits)
+      throw std::runtime_error("WalshMerit: generating matrix has the wrong size");
+
+   // flipping bit b of h flips bit s of C^T h if bit b of column s is set
+   std::vector<uint64_t> flips(m_numDigits, 0);
+   for (unsigned s = 0; s < m_numDigits; s++)
+      for (uint64_t col = mat.column(s); col; col &= col - 1)
+         flips[trailingZeros(col)] |= uint64_t(1) << s;
+
+   const Modulus n = numPoints();
+   std::fill(out, out + n, 0.0);
+   out[0] = 1.0 + weight * m_coefficients[0];
+   uint64_t y = 0;
+   for (Modulus i = 1; i < n; i++) {
+      y ^= flips[trailingZeros(i)];
+      out[y] += weight * m_coefficients[i ^ (i >> 1)];
+   }
+}
+
+Real WalshMerit::evaluate(
+      const LatDef<LatType::ORDINARY>& lat,
+      const ProductWeights& weights,
+      RealVector& prod,
+      RealVector& work) const
+{
+   if (deg(lat.sizeParam().polynomial()) != long(m_numDigits))
+      throw std::runtime_error("WalshMerit: lattice has the wrong modulus degree");
+
+   const Modulus n = numPoints();
+   const auto mats = generatingMatrices(lat);
+   prod.assign(n, 1.0);
+   work.resize(n);
+   for (Dimension j = 0; j < mats.size(); j++) {
+      indicatorVector(mats[j], weights.weight(j), work.data());
+      fwht(work);
+      for (Modulus k = 0; k < n; k++)
+         prod[k] *= work[k];
+   }
+
+   Real sum = 0.0;
+   for (Modulus k = 0; k < n; k++)
+      sum += prod[k];
+   return sum / Real(n) - 1.0;
+}
+
+Real WalshMerit::operator()(const LatDef<LatType::ORDINARY>& lat, const ProductWeights& weights) const
+{
+   RealVector prod, work;
+   return evaluate(lat, weights, prod, work);
+}
+
+RealVector WalshMerit::operator()(
+      const std::vector<LatDef<LatType::ORDINARY>>& lats,
+      const ProductWeights& weights,
+      unsigned numThreads) const
+{
+   for (const auto& lat : lats) {
+      if (deg(lat.sizeParam().polynomial()) != long(m_numDigits))
+         throw std::runtime_error("WalshMerit: lattice has the wrong modulus degree");
+   }
+
+   RealVector merits(lats.size());
+   Parallel::BlockCursor cursor(lats.size(), 1);
+   // the first exception thrown by a worker, rethrown after all threads
+   // have joined
+   std::exception_ptr error;
+   std::mutex errorMutex;
+
+   auto worker = [&]() {
+      try {
+         RealVector prod, work;
+         size_t first, count;
+         while (cursor.next(first, count))
+            merits[first] = evaluate(lats[first], weights, prod, work);
+      }
+      catch (...) {
+         std::lock_guard<std::mutex> lock(errorMutex);
+         if (not error)
+            error = std::current_exception();
+         cursor.stop();
+      }
+   };
+
+   if (numThreads == 0)
+      numThreads = std::thread::hardware_concurrency();
+   numThreads = std::max<size_t>(1, std::min<size_t>(numThreads, lats.size()));
+   std::vector<std::thread> threads;
+   for (unsigned i = 1; i < numThreads; i++)
+      threads.emplace_back(worker);
+   worker();
+   for (auto& t : threads)
+      t.join();
+   if (error)
+      std::rethrow_exception(error);
+
+   return merits;
+}
+
+}
@@ -0,0 +1,144 @@
+// This file is part of Lattice Builder.
+//
+// Copyright (C) 2012-2016  Pierre L'Ecuyer and Universite de Montreal
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * \file
+ * Checks CoordUniformCBC::extend() against a brute-force search.
+ *
+ * For moduli \f$P\f$ equal to \f$x^m\f$ or to \f$x^m + x^3 + x + 1\f$,
+ * and for \f$m = 5, \dots, 16\f$, a lattice built with modulus \f$P\f$ is
+ * extended to \f$P' = x^{m+1}\f$ or \f$P' = P (x^2 + x + 1)\f$ with each
+ * backend.  The points are then visited in the embedded
+ * order, and every selected component must have the smallest merit among
+ * its GenSeq::Extend candidates, as computed by an evaluator that visits
+ * the points in the usual order; the merit of the extended lattice must
+ * also agree with that evaluator.
+ *
+ * Returns a nonzero exit status if a check fails.
+ */
+
+#include "PolLatbuilder/MeritSeq/CoordUniformCBC.h"
+#include "PolLatbuilder/Kernel/PAlphaPLR.h"
+#include "PolLatbuilder/GenSeq/CoprimePolynomials.h"
+#include "PolLatbuilder/GenSeq/Extend.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace PolLatBuilder;
+
+namespace {
+   typedef MeritSeq::CoordUniformCBC<Kernel::PAlphaPLR> CBC;
+
+   const Dimension dimension = 4;
+
+   /**
+    * Returns \c true if \c a and \c b agree up to rounding; merits of the
+    * first coordinates result from the cancellation of terms of order 1,
+    * hence the absolute tolerance.
+    */
+   bool close(Real a, Real b)
+   { return std::abs(a - b) <= 1e-12 * std::abs(b) + 1e-14; }
+
+   /**
+    * Builds a lattice with modulus \c base and returns its generating
+    * vector, with the current PolyModP modulus set to \c base.
+    */
+   GeneratingVector baseGenerators(const Kernel::PAlphaPLR& kernel, const ProductWeights& weights, const Poly& base)
+   {
+      GF2E::init(base);
+      const SizeParam<LatType::ORDINARY> sizeParam(base);
+      GenSeq::CoprimePolynomials<> all(base);
+      std::vector<PolyModP> candidates;
+      for (size_t i = 0; i < std::min<size_t>(all.size(), 500); i++)
+         candidates.push_back(all[(i * 7919) % all.size()]);
+      auto cbc = MeritSeq::coordUniformCBC(sizeParam, kernel, weights);
+      for (Dimension j = 0; j < dimension; j++)
+         cbc.selectBest(candidates);
+      return cbc.baseLat().gen();
+   }
+
+   /**
+    * Extends the lattice with modulus \c base and generators \c gens to
+    * the modulus \c modulus with \c backend, and returns the number of
+    * failed checks.
+    */
+   unsigned check(
+         const Kernel::PAlphaPLR& kernel, const ProductWeights& weights,
+         const Poly& base, const GeneratingVector& gens, const Poly& modulus,
+         CBC::Backend backend)
+   {
+      GF2E::init(modulus);
+      GeneratingVector lifted;
+      for (const auto& g : gens)
+         lifted.push_back(conv<PolyModP>(rep(g)));
+      const auto baseLat = createLatDef(SizeParam<LatType::ORDINARY>(base), lifted);
+
+      const SizeParam<LatType::ORDINARY> sizeParam(modulus);
+      auto ext = MeritSeq::coordUniformCBC(sizeParam, kernel, weights);
+      ext.setBackend(backend);
+      const Real merit = ext.extend(baseLat);
+
+      unsigned failures = 0;
+      auto ref = MeritSeq::coordUniformCBC(sizeParam, kernel, weights);
+      for (Dimension j = 0; j < ext.baseLat().dimension(); j++) {
+         Real best = 0.0;
+         bool first = true;
+         for (const auto& candidate : GenSeq::Extend<>(modulus, base, rep(gens[j]))) {
+            const Real value = ref(candidate);
+            if (first or value < best)
+               best = value;
+            first = false;
+         }
+         const Real selected = ref(ext.baseLat().gen()[j]);
+         if (not close(selected, best)) {
+            std::cout << "  coordinate " << j << ": selected " << selected << ", best " << best << std::endl;
+            failures++;
+         }
+         ref.select(ext.baseLat().gen()[j]);
+      }
+      if (not close(merit, ref.baseMerit())) {
+         std::cout << "  merit " << merit << ", expected " << ref.baseMerit() << std::endl;
+         failures++;
+      }
+      return failures;
+   }
+}
+
+int main()
+{
+   const Kernel::PAlphaPLR kernel(2.0);
+   const ProductWeights weights(0.7);
+   const CBC::Backend backends[] = { CBC::Backend::AUTO, CBC::Backend::TILED, CBC::Backend::BIT_SLICED };
+   const char* backendNames[] = { "auto", "tiled", "bit-sliced" };
+
+   unsigned failures = 0;
+   for (unsigned m = 5; m <= 16; m++) {
+      for (bool monomial : { true, false }) {
+         const Poly base = monomial ? intToPoly(1ul << m) : intToPoly((1ul << m) | 0xb);
+         const Poly modulus = monomial ? intToPoly(1ul << (m + 1)) : base * intToPoly(0x7);
+         const GeneratingVector gens = baseGenerators(kernel, weights, base);
+         for (unsigned b = 0; b < 3; b++) {
+            const unsigned n = check(kernel, weights, base, gens, modulus, backends[b]);
+            std::cout << "m = " << m << (monomial ? ", x^m" : ", P (x^2 + x + 1)") << ", " << backendNames[b]
+               << ": " << (n ? "FAILED" : "ok") << std::endl;
+            failures += n;
+         }
+      }
+   }
+   return failures ? 1 : 0;
+}